@@ -36,9 +36,15 @@ public:
 
     dsp_float* getBuffer();
 
+    // Generates the samples [start, end) of the current block
+    void generate(size_t start, size_t end);
+
     void triggerStart();
     void triggerStop();
 
+    // True if the envelope has finished and outputs zero
+    bool isIdle() const { return phase == ADSRPhase::Idle; }
+
 private:
     // Next sample block generation
     static void processBlock(DSPObject *dsp);
@@ -41,7 +41,7 @@ public:
     static constexpr size_t maxBlockSize = 2048;
 
     // The max sample rate
-    static constexpr dsp_float maxSamplerate = 96000.0;
+    static constexpr dsp_float maxSamplerate = 192000.0;
 
     // Threshold for zeroing
     static constexpr dsp_float epsilon = 1e-10;
@@ -60,4 +60,4 @@ private:
     static LogFunc logger;
     static bool logFileInitialized;
     // TODO: fix for gcc 6 static inline std::mutex logFileMutex;
-};
\ No newline at end of file
+};
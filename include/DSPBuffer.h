@@ -12,10 +12,10 @@ public:
     // Constructor with optional initial size (default: 2048 samples)
     explicit DSPBuffer();
 
-    // Resize the internal buffer and initialize new elements to 0.0
+    // Resize the internal buffer and initialize new elements to 0.0, the storage shrinks to the new size
     void resize(size_t newSize);
 
-    // Set all buffer elements to 0.0
+    // Set all buffer elements to 0.0, bulk operations cover the buffer's own size
     void clear();
 
     // Return a mutable pointer to the internal buffer data
@@ -36,14 +36,14 @@ public:
     // Multiply all buffer samples by a scalar gain value
     void applyGain(dsp_float gain);
 
-    // Copy contents from another DSPBuffer instance
+    // Copy contents from another DSPBuffer instance, as many samples as both buffers hold
     void set(const DSPBuffer &other);
 
-    // Copy raw data from an external float array into the buffer
+    // Copy raw data from an external float array into the buffer, the source holds at least size() samples
     void set(const float *source);
 
 #ifdef USE_DOUBLE_PRECISION
-    // Copy raw data from an external dsp_float array into the buffer
+    // Copy raw data from an external dsp_float array into the buffer, the source holds at least size() samples
     void set(const double *source);
 #endif
 
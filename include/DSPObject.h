@@ -16,6 +16,16 @@ public:
     // Initializes a DSP-Object
     virtual void initialize();
 
+    // Sets the sample rate and block size the object renders at, takes effect with the next
+    // initialize. An object never set renders at the host sample rate and block size
+    void setAudioSettings(dsp_float rate, size_t size);
+
+    // Gets the sample rate the object renders at
+    dsp_float getSampleRate() const { return audioRate > 0.0 ? audioRate : DSP::sampleRate; }
+
+    // Gets the block size the object renders at
+    size_t getBlockSize() const { return audioBlockSize > 0 ? audioBlockSize : DSP::blockSize; }
+
     // Calculates the next sample buffer
     void generateBlock();
 
@@ -32,4 +42,8 @@ private:
 
     // Sample generation from derived class
     BlockProcessor processBlockFunc;
+
+    // Own sample rate and block size, 0 for the host's
+    dsp_float audioRate = 0.0;
+    size_t audioBlockSize = 0;
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "DSP.h"
+#include "DSPBuffer.h"
+#include "DSPObject.h"
+#include "dsp_types.h"
+
+// The Ensemble is a stereo chorus on the summed output in the manner of
+// the string ensembles: per channel three taps read a delay line whose
+// delay is modulated by a slow and a fast LFO, the taps 120 degrees apart
+// and the right channel in opposite phase to the left one.
+// Both channels share one contiguous ring buffer of interleaved frames and
+// the two LFOs. The LFOs are evaluated at the block boundaries only, the
+// tap delays ramp linearly in between.
+class Ensemble : public DSPObject
+{
+public:
+    // Taps per channel
+    static constexpr int TapCount = 3;
+
+    // Longest delay in ms
+    static constexpr dsp_float maxDelay = 40.0;
+
+    // Ctor
+    Ensemble();
+
+    // Allocates the delay line for the current sample rate and clears it
+    void initialize() override;
+
+    // Sets the wet share 0 - 1, 0 bypasses the ensemble
+    void setMix(dsp_float value);
+
+    // Sets the rate of the slow LFO in Hz, the vibrato LFO runs ten times faster
+    void setRate(dsp_float hz);
+
+    // Sets the delay modulation of the slow LFO in ms, the vibrato LFO modulates a tenth
+    void setDepth(dsp_float ms);
+
+    // Sets the center delay of the taps in ms
+    void setDelay(dsp_float ms);
+
+    // True if the ensemble is heard or fades out
+    bool isActive() const;
+
+    // Processes the first samples of left and right in place
+    void process(DSPBuffer &left, DSPBuffer &right, size_t samples);
+
+private:
+    // Delays in samples of all taps at the given LFO phases, left taps first
+    void tapDelays(dsp_float slow, dsp_float fast, dsp_float *delays) const;
+
+    std::vector<dsp_float> ring; // Interleaved left/right frames
+    size_t mask = 0;             // Frames in the ring - 1
+    size_t writeFrame = 0;       // Next frame written
+
+    dsp_float mix = 0.0;        // Wet share as set
+    dsp_float currentMix = 0.0; // Wet share reached at the end of the last block
+    dsp_float rate = 0.6;       // Slow LFO rate in Hz
+    dsp_float depth = 2.0;      // Slow LFO depth in ms
+    dsp_float delay = 12.0;     // Center delay in ms
+    dsp_float slowPhase = 0.0;  // Slow LFO phase 0 - 1
+    dsp_float fastPhase = 0.0;  // Vibrato LFO phase 0 - 1
+
+    // Rate and depth of the vibrato LFO relative to the slow one
+    static constexpr dsp_float fastRatio = 10.0;
+    static constexpr dsp_float fastDepth = 0.1;
+};
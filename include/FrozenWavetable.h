@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "DSP.h"
+#include "DSPObject.h"
+#include "dsp_types.h"
+
+// The FrozenWavetable bakes one cycle of a static oscillator configuration
+// into a band-limited mipmap with one table per octave. The cycle is
+// sampled once, then its harmonics are analysed and summed into the tables
+// a few per call, so building spreads over many blocks while the voice
+// keeps rendering live. A ready mipmap renders the configuration with one
+// table read per sample.
+class FrozenWavetable : public DSPObject
+{
+public:
+    // Samples per cycle and per table, a power of two
+    static constexpr size_t tableSize = 2048;
+
+    // Number of octave tables, the first one is for fundamentals up to 40 Hz
+    static constexpr int levelCount = 10;
+
+    // Ctor
+    FrozenWavetable();
+
+    // Allocates the tables for the current sample rate and drops a frozen cycle
+    void initialize() override;
+
+    // Starts building from one cycle of waveform(phase), phase 0 - 1
+    template <typename Waveform>
+    void begin(Waveform waveform)
+    {
+        for (size_t k = 0; k < tableSize; ++k)
+            cycle[k] = waveform(static_cast<dsp_float>(k) / tableSize);
+
+        start();
+    }
+
+    // Analyses and adds the next count harmonics, true once all tables are complete
+    bool build(int count);
+
+    // Drops the frozen cycle
+    void reset();
+
+    // True while harmonics are still added
+    bool isBuilding() const;
+
+    // True if the tables are complete
+    bool isReady() const;
+
+    // Renders the samples [start, end) into out, the phase before start advances
+    // by increment per sample ahead of each read like in the oscillators
+    void render(dsp_float *out, dsp_float phase, dsp_float increment, size_t start, size_t end) const;
+
+private:
+    // Sets up the harmonic sum after the cycle was sampled
+    void start();
+
+    std::vector<dsp_float> cycle;  // One cycle of the waveform
+    std::vector<dsp_float> sine;   // One sine cycle, harmonic n reads every n-th sample
+    std::vector<dsp_float> sum;    // Harmonics added so far
+    std::vector<dsp_float> tables; // The octave tables one after the other
+
+    int harmonicLimit[levelCount]; // Highest harmonic of each table
+    int harmonic = 0;              // Next harmonic to add, 0 if not building
+    dsp_float dc = 0.0;            // Mean of the cycle
+    bool ready = false;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "HalfbandUpsampler.h"
+#include "dsp_types.h"
+
+// The HalfbandDecimator halves the sample rate of one or more channels with
+// the half-band filter of the HalfbandUpsampler. Only the kept outputs are
+// computed: the center tap is a delayed input sample, the folded symmetric
+// branch costs 16 multiplies per output sample. The group delay is 31 input
+// samples.
+class HalfbandDecimator
+{
+public:
+    // Taps of the computed branch
+    static constexpr int branchTaps = HalfbandUpsampler::branchTaps;
+
+    // Ctor
+    HalfbandDecimator();
+
+    // Allocates the state for channels of up to samples output samples per block
+    void initialize(int channels, size_t samples);
+
+    // Clears the filter history
+    void reset();
+
+    // Clears the filter history of one channel
+    void reset(int channel);
+
+    // Continues a channel from the filter history of another channel
+    void copy(int channel, int source);
+
+    // Decimates 2 * samples input samples of one channel, returns samples output samples
+    const dsp_float *process(int channel, const dsp_float *input, size_t samples);
+
+private:
+    dsp_float coefficients[branchTaps]; // Branch coefficients, symmetric
+
+    std::vector<std::vector<dsp_float>> history; // Per channel: the last 2 * (branchTaps - 1) inputs
+    std::vector<dsp_float> work;                 // History and input of the current block
+    std::vector<dsp_float> output;               // Decimated block
+};
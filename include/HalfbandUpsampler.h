@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "dsp_types.h"
+
+// The HalfbandUpsampler doubles the sample rate of one or more channels with
+// a linear phase half-band FIR (Kaiser windowed sinc, about 70 dB image
+// rejection). It runs in polyphase form: every other output is a delayed
+// input sample, the others come from a folded symmetric branch, so each
+// input sample costs 16 multiplies. The group delay is 15.5 input samples.
+class HalfbandUpsampler
+{
+public:
+    // Taps of the computed branch
+    static constexpr int branchTaps = 32;
+
+    // Ctor
+    HalfbandUpsampler();
+
+    // Allocates the state for channels of up to samples input samples per block
+    void initialize(int channels, size_t samples);
+
+    // Clears the filter history
+    void reset();
+
+    // Clears the filter history of one channel
+    void reset(int channel);
+
+    // Continues a channel from the filter history of another channel
+    void copy(int channel, int source);
+
+    // Upsamples a block of one channel, returns 2 * samples output samples
+    const dsp_float *process(int channel, const dsp_float *input, size_t samples);
+
+    // Computes the branch coefficients, the decimator uses the same filter
+    static void calcCoefficients(dsp_float *coefficients);
+
+private:
+    dsp_float coefficients[branchTaps]; // Branch coefficients, symmetric
+
+    std::vector<std::vector<dsp_float>> history; // Per channel: the last branchTaps - 1 inputs
+    std::vector<dsp_float> work;                        // History and input of the current block
+    std::vector<dsp_float> output;                      // Upsampled block
+};
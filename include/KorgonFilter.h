@@ -17,6 +17,13 @@ public:
     // Sets the filter drive
     void setDrive(dsp_float value);
 
+    // Enables the soft clipping output stage, off runs the filter linear
+    void setSaturation(bool enabled);
+
+    // Runs the filter on samples at 1, 2 or 4 times the sample rate, the cutoff and
+    // resonance inputs stay at the sample rate
+    void setOversampling(int factor);
+
     // Set cutoff frequency in Hz
     void setCutoff(DSPBuffer *buffer);
 
@@ -26,10 +33,22 @@ public:
     // Assigns the samples to process
     void setSampleBuffers(DSPBuffer *samplesL, DSPBuffer *samplesR);
 
+    // Filters the samples [start, end) of the sample buffers in place
+    void process(size_t start, size_t end);
+
+    // Filters the samples [start, end) of the left buffer only, the right state follows the left
+    void processMono(size_t start, size_t end);
+
     // Reset internal filter state
     void reset();
 
+    // True if the cutoff is fully open for the samples [start, end), the filter passes the signal
+    bool isOpen(size_t start, size_t end) const;
+
 private:
+    // The lane renderer works on the filter state directly
+    friend class VoiceLanes;
+
     // Filter state variables:
     dsp_float y1L;   // Output of first integrator left
     dsp_float y2L;   // Output of second integrator (filter output) left
@@ -37,12 +56,18 @@ private:
     dsp_float y2R;   // Output of second integrator (filter output) right
     dsp_float T;     // Simplified impulse invariant/bilinear transformation
     dsp_float drive; // The filter drive
+    bool saturated = true; // Soft clipping output stage active
+    int controlShift = 0;  // log2 of the oversampling factor, sample index to control index
 
     static dsp_float nonlinearFeedback(dsp_float s); // Nonlinear feedback (simulates diode behavior)
 
     // Processes data in bufferL, buffer R
     static void processBlock(DSPObject *dsp);
 
+    // Filter loop, Mono processes the left channel only, Saturated soft clips the output
+    template <bool Mono, bool Saturated>
+    void processKernel(size_t start, size_t end);
+
     // The samples to be filtered
     DSPBuffer *bufferL;
     DSPBuffer *bufferR;
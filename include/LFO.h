@@ -33,6 +33,9 @@ public:
     void setIdleSignal(double f);
     void reset();
 
+    // Evaluates the LFO once and advances it by samples, for control rate modulation
+    dsp_float tick(size_t samples);
+
     void setModBuffer(float* buffer);
     dsp_float* getBuffer();
 
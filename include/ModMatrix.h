@@ -0,0 +1,31 @@
+#pragma once
+
+#include "VoiceOptions.h"
+#include "dsp_types.h"
+
+// The ModMatrix class routes the modulation sources of a voice to its
+// destinations. A route is an amount, every destination receives the sum of
+// its sources scaled by their amounts. The voice evaluates the matrix at
+// control rate, not per sample.
+class ModMatrix
+{
+public:
+    // Sets the amount a source modulates a destination, 0 removes the route
+    void setAmount(ModSource source, ModDestination destination, dsp_float amount);
+
+    // True if any route is set
+    bool isActive() const;
+
+    // True if the destination receives at least one source
+    bool isRouted(ModDestination destination) const;
+
+    // True if the source feeds at least one destination
+    bool uses(ModSource source) const;
+
+    // Sums the scaled source values per destination
+    void evaluate(const dsp_float *sources, dsp_float *destinations) const;
+
+private:
+    dsp_float amounts[ModSourceCount][ModDestinationCount] = {}; // Route amounts
+    int routes = 0;                                              // Number of routes set
+};
@@ -16,6 +16,9 @@ public:
     // Apply all queued changes
     void processChanges(DSPBuffer &left, DSPBuffer &right);
 
+    // Apply all queued changes at once without fading
+    void flush();
+
 private:
     std::queue<ParamChange> changes;
     int fadeCounter = 0;           // Amplitude for param change
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+#include "VoiceParameters.h"
+
+// The ParameterBlock holds the sound parameters shared by several engines.
+// The control thread writes it once per change, every engine reads it by
+// reference at the start of a block. A sequence counter lets a reader on
+// another thread detect a copy torn by a concurrent write and retry, neither
+// side ever blocks.
+class alignas(64) ParameterBlock
+{
+public:
+    // Ctor: default parameters
+    ParameterBlock();
+
+    ParameterBlock(const ParameterBlock &) = delete;
+    ParameterBlock &operator=(const ParameterBlock &) = delete;
+
+    // Writer: replaces the parameters
+    void write(const VoiceParameters &values);
+
+    // Reader: copies the parameters if they changed since version and updates version,
+    // false if nothing changed
+    bool read(VoiceParameters &values, unsigned long &version) const;
+
+private:
+    std::atomic<unsigned long> sequence{0}; // Odd while a write is in progress
+    VoiceParameters parameters;
+};
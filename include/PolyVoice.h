@@ -0,0 +1,270 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "Voice.h"
+#include "VoiceOptions.h"
+#include "DSPObject.h"
+#include "DSPBuffer.h"
+#include "WorkerPool.h"
+#include "VoiceLanes.h"
+#include "Ensemble.h"
+#include "ParameterBlock.h"
+#include "QualityGovernor.h"
+#include "dsp_types.h"
+
+class PolyVoice;
+
+// A voice slot of the polyphonic engine
+struct PolySlot
+{
+    PolyVoice *engine;      // The owning engine
+    Voice *voice;           // The synth voice with its envelopes
+    int note = -1;          // MIDI note played by the slot, -1 if unused
+    bool held = false;      // True while the key is down
+    unsigned long age = 0;  // Allocation order for voice stealing
+    bool rendered = false;  // True if the voice produced output this block
+};
+
+// A group of awake voice slots rendered side by side
+struct LaneGroup
+{
+    PolyVoice *engine;          // The owning engine
+    VoiceLanes lanes;           // Lane renderer with its work buffers
+    PolySlot *slots[LaneCount]; // Slots rendered in this block
+    int count = 0;              // Number of slots in use
+};
+
+// The PolyVoice class owns N voices, allocates and steals them on
+// note messages and sums them into one stereo output.
+// With envelopes disabled it drives a single voice like the plain jpvoice~.
+class PolyVoice : public DSPObject
+{
+public:
+    // Number of preset slots
+    static constexpr int presetCount = 32;
+
+    // Ctor: number of voices
+    explicit PolyVoice(int count);
+
+    // Dtor: deletes all voices
+    ~PolyVoice();
+
+    // Initializes the voices
+    void initialize() override;
+
+    // Enables note allocation and the voices' envelopes
+    void setEnvelopesEnabled(bool enabled);
+
+    // Gets the number of voices
+    int getVoiceCount() const;
+
+    // Plays a MIDI note at a sample offset within the next block, velocity 0 releases the note
+    void noteOn(int note, dsp_float velocity, size_t offset = 0);
+
+    // Releases a MIDI note at a sample offset within the next block
+    void noteOff(int note, size_t offset = 0);
+
+    // Plays a chord through every voice, pitches in semi tones relative to the note.
+    // Fewer than two notes end the chord
+    void setChord(const dsp_float *semitones, int count);
+
+    // Paraphonic mode: the held notes play as a chord through the first voice, sharing its filter
+    // and envelopes. The lowest note sets the voice frequency, the first note opens the gate
+    void setParaphonic(bool enabled);
+
+    // Sets the pitch bend in semi tones, the voices smooth it over the bend time
+    void setPitchBend(dsp_float semitones, size_t offset = 0);
+
+    // Sets the portamento time in ms and its curve, 0 jumps to a new note
+    void setGlide(dsp_float ms, SlewMode mode);
+
+    // Sets the time in ms a pitch bend change is smoothed over
+    void setBendTime(dsp_float ms);
+
+    // Sets the output gain of the summed voices
+    void setGain(dsp_float g);
+
+    // Sets a parameter of all amplitude envelopes
+    void setAmpEnvelope(EnvelopeParam param, dsp_float value);
+
+    // Sets a parameter of all filter envelopes
+    void setFilterEnvelope(EnvelopeParam param, dsp_float value);
+
+    // Voice parameters, applied to all voices. Where given, offset is the
+    // sample within the next block the change takes effect at.
+    void setModIndex(dsp_float index, size_t offset = 0);
+    void setSyncEnabled(bool enabled, size_t offset = 0);
+    void setPitchOffset(int pitchOffset, size_t offset = 0);
+    void setFineTune(dsp_float fine, size_t offset = 0);
+    void setFrequency(dsp_float f, size_t offset = 0);
+    void setNumVoices(int count, size_t offset = 0);
+    void setOscillatorMix(dsp_float mix, size_t offset = 0);
+    void setNoiseMix(dsp_float mix, size_t offset = 0);
+    void setCarrierOscillatorType(CarrierOscillatiorType oscillatorType, size_t offset = 0);
+    void setModulatorOscillatorType(ModulatorOscillatorType oscillatorType, size_t offset = 0);
+    void setNoiseType(NoiseType type);
+    void setDetune(dsp_float value, size_t offset = 0);
+    void setFeedbackCarrier(dsp_float feedback, size_t offset = 0);
+    void setFeedbackModulator(dsp_float feedback, size_t offset = 0);
+    void setFilterMode(FilterMode mode);
+    void setFilterCutoff(DSPBuffer *buffer);
+    void setFilterResonance(DSPBuffer *buffer);
+    void setFilterDrive(dsp_float value);
+    void setGate(bool open, size_t offset = 0);
+    void setExternalAmplitude(DSPBuffer *buffer);
+    void setSmoothTime(dsp_float ms);
+    void setTileSize(int samples);
+    void setModulation(ModSource source, ModDestination destination, dsp_float amount);
+    void setModLfo(LFOParam param, dsp_float value);
+    void setControlRate(int samples);
+
+    // Sets a parameter of the ensemble on the summed output, separate outputs bypass it
+    void setEnsemble(EnsembleParam param, dsp_float value);
+
+    // Gets a snapshot of the sound parameters of the voices
+    VoiceParameters getParameters() const;
+
+    // Applies a snapshot to all voices, stops a running morph
+    void setParameters(const VoiceParameters &parameters);
+
+    // Stores the current sound parameters in a preset slot
+    void storePreset(int slot);
+
+    // Recalls a preset slot at once, stops a running morph
+    void recallPreset(int slot);
+
+    // Morphs from the current sound parameters to a preset slot over ms milliseconds
+    void morphPreset(int slot, dsp_float ms);
+
+    // Applies a blend of two preset slots, amount 0 is a and 1 is b
+    void blendPresets(int a, int b, dsp_float amount);
+
+    // Reads the sound parameters from a shared block at the start of every block, nullptr detaches.
+    // Only parameters changed in the block are applied, other messages to the voices stay in effect.
+    // Attaching a block creates the oscillators of every type, the block may switch to any of them
+    void setParameterBlock(const ParameterBlock *block);
+
+    // Sets the number of worker threads rendering the voices, 0 renders on the DSP thread
+    void setThreads(int count);
+
+    // Sets the cpus the worker threads are pinned to, empty for no pinning
+    void setAffinity(const std::vector<int> &cpus);
+
+    // Sets the time in microseconds an idle worker spins before it parks
+    void setSpinTime(dsp_float us);
+
+    // Renders the awake voices in groups of LaneCount lanes, modulated voices render one by one
+    void setLanesEnabled(bool enabled);
+
+    // Freezes static carrier and modulator setups into a single table per voice, lane rendering plays them live
+    void setFreezeEnabled(bool enabled);
+
+    // Runs the mixer feedback and the filter of the voices at 1, 2 or 4 times their rate, oversampled voices render one by one
+    void setOversampling(int factor);
+
+    // Enables the quality governor, it lowers the voice quality when a block takes too long
+    void setGovernorEnabled(bool enabled);
+
+    // Sets the load (render time / deadline) the governor steps down at and the load it steps up at
+    void setGovernorThresholds(dsp_float high, dsp_float low);
+
+    // Gets the current quality level, 0 is full quality, safe to call from any thread
+    int getQualityLevel() const;
+
+    // Writes every voice to its own output channel instead of summing them, set before initialize
+    void setSeparateOutputs(bool enabled);
+
+    // Gets the number of output channels per side, 1 for the stereo sum or the voice count
+    int getOutputChannels() const;
+
+    // Next sample block generation
+    void computeSamples();
+
+    // Output, one block per channel one after the other
+    DSPBuffer mixBufferL; // Summed or per voice output left channel
+    DSPBuffer mixBufferR; // Summed or per voice output right channel
+
+private:
+    // Finds the slot for a new note: same note, free, released or oldest
+    PolySlot *allocate(int note);
+
+    // Adds a note to the paraphonic stack, the oldest note gives way when it is full
+    void paraphonicNoteOn(int note, dsp_float velocity, size_t offset);
+
+    // Removes a note from the paraphonic stack, the last one closes the gate
+    void paraphonicNoteOff(int note, size_t offset);
+
+    // Plays the held notes through the first voice
+    void updateParaphony(size_t offset);
+
+    // Renders one voice slot, runs on the DSP thread or a worker
+    static void renderSlot(void *arg);
+
+    // Renders a lane group, runs on the DSP thread or a worker
+    static void renderGroup(void *arg);
+
+    // Groups the awake voices and renders the groups
+    void renderLanes();
+
+    // Marks a rendered slot and frees it when its released note has faded out
+    void finishSlot(PolySlot &slot);
+
+    // Applies the quality of the governor's level to all voices
+    void applyQuality();
+
+    // Advances a running preset morph by one block
+    void advanceMorph();
+
+    // Applies the changes of the shared parameter block
+    void applyParameterBlock();
+
+    // Converts a MIDI note to Hertz
+    static dsp_float mtof(dsp_float note);
+
+    std::vector<PolySlot> slots;
+    std::vector<void *> slotArgs; // Job arguments for the worker pool
+
+    // Lane parallel rendering
+    std::vector<LaneGroup> laneGroups;
+    std::vector<void *> groupArgs; // Job arguments for the worker pool
+    bool lanesEnabled = false;
+
+    // Worker pool for parallel voice rendering
+    WorkerPool pool;
+    int threadCount = 0;
+    std::vector<int> affinity;
+
+    // Quality governor measuring the render time per block
+    QualityGovernor governor;
+
+    // Stereo ensemble on the summed voices
+    Ensemble ensemble;
+    std::atomic<int> qualityLevel{0};
+
+    // Preset slots and the running morph
+    std::vector<VoiceParameters> presets;
+    VoiceParameters morphFrom;     // Parameters the morph started at
+    VoiceParameters morphTo;       // Parameters the morph ends at
+    dsp_float morphPosition = 0.0; // Morph progress 0 - 1
+    dsp_float morphStep = 0.0;     // Progress per block
+    bool morphing = false;         // True while a morph runs
+
+    // Shared parameter block
+    const ParameterBlock *parameterBlock = nullptr;
+    VoiceParameters blockParameters; // Block parameters applied last
+    unsigned long blockVersion = 0;  // Block version applied last
+
+    DSPBuffer *cutoffBuffer = nullptr; // Cutoff input shared by all voices
+    DSPBuffer cutoffInitBuffer;        // Default cutoff input
+
+    // Paraphonic note stack in arrival order
+    int noteStack[WavetableOscillator::maxVoices];
+    int stackSize = 0;
+    bool paraphonic = false;
+
+    bool envelopesEnabled = false; // Note allocation and voice envelopes active
+    bool separateOutputs = false;  // One output channel per voice
+    dsp_float gain = 1.0;          // Output gain
+    unsigned long noteCounter = 0; // Allocation counter
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "VoiceOptions.h"
+#include "dsp_types.h"
+
+// The QualityGovernor compares the measured render time of a block with
+// the block deadline and picks a quality level. Under pressure it steps
+// down at once, with headroom it steps up again only after the load has
+// stayed below a lower threshold for a while (hysteresis).
+// Level 0 is full quality, every level adds a reduction to the one below.
+class QualityGovernor
+{
+public:
+    // Number of quality levels
+    static constexpr int levelCount = 6;
+
+    // Ctor
+    QualityGovernor();
+
+    // Enables the governor, disabled it stays on full quality
+    void setEnabled(bool enabled);
+
+    // True if the governor is enabled
+    bool isEnabled() const;
+
+    // Sets the load (render time / deadline) stepping down and the load stepping up again
+    void setThresholds(dsp_float high, dsp_float low);
+
+    // Takes the render time of the last block and the deadline, the duration of the block,
+    // in seconds, true if the level changed
+    bool update(double seconds, double deadline);
+
+    // Gets the current quality level
+    int getLevel() const;
+
+    // Gets the smoothed load of the last blocks
+    dsp_float getLoad() const;
+
+    // Gets the voice quality of a level
+    static VoiceQuality getQuality(int level);
+
+private:
+    bool enabled = false;
+    int level = 0;
+
+    dsp_float highLoad = 0.8; // Load stepping down
+    dsp_float lowLoad = 0.5;  // Load stepping up
+    dsp_float load = 0.0;     // Smoothed load
+
+    int overBlocks = 0;    // Consecutive blocks above the high load
+    long holdBlocks = 0;   // Blocks until the next step up is allowed
+    long settleBlocks = 0; // Blocks until the next step down is allowed
+
+    // Blocks above the high load before stepping down
+    static constexpr int stepDownBlocks = 2;
+
+    // Time in ms a step down takes effect before the next one
+    static constexpr dsp_float settleTime = 20.0;
+
+    // Time in ms the load has to stay below the low load before stepping up
+    static constexpr dsp_float recoveryTime = 1000.0;
+};
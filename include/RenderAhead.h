@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "DSP.h"
+#include "DSPBuffer.h"
+#include "HalfbandUpsampler.h"
+#include "PolyVoice.h"
+#include "SpscRing.h"
+
+// A call on the engine queued by the control thread
+struct RenderCommand
+{
+    // Bytes available for the captured arguments
+    static constexpr size_t closureSize = 64;
+
+    void (*invoke)(PolyVoice *engine, const void *closure) = nullptr;
+    unsigned long frame = 0; // First frame the call takes effect in
+    alignas(16) unsigned char closure[closureSize];
+};
+
+// A block in flight between the DSP thread and the render thread
+struct RenderFrame
+{
+    DSPBuffer cutoff;    // Cutoff input
+    DSPBuffer resonance; // Resonance input
+    DSPBuffer amplitude; // Amplitude input
+    DSPBuffer outL;      // Rendered output left, all channels
+    DSPBuffer outR;      // Rendered output right, all channels
+};
+
+// The RenderAhead class optionally renders the engine a fixed number of
+// blocks ahead on a producer thread. The DSP thread hands over its input
+// block and copies out a finished block from a lock-free ring, so a slow
+// block is absorbed by the latency instead of missing the deadline.
+// Every call on the engine goes through post and is replayed on the render
+// thread in front of the block it was sent for.
+// With a latency of 0 the engine renders on the DSP thread as before.
+// Optionally the engine renders on the DSP thread at half the host rate and
+// the output is upsampled, the engine and its components then run at the
+// internal sample rate and block size.
+class RenderAhead
+{
+public:
+    // Maximum latency in blocks
+    static constexpr int maxLatency = 8;
+
+    // Ctor: the engine rendered
+    explicit RenderAhead(PolyVoice *engine);
+
+    // Dtor: stops the render thread
+    ~RenderAhead();
+
+    RenderAhead(const RenderAhead &) = delete;
+    RenderAhead &operator=(const RenderAhead &) = delete;
+
+    // Sets the latency in blocks, 0 renders on the DSP thread
+    void setLatency(int blocks);
+
+    // Gets the latency in blocks
+    int getLatency() const;
+
+    // Renders the engine at the host rate divided by 1 or 2, takes effect with the next initialize.
+    // Rendering ahead is only available at the host rate
+    void setRateDivider(int divider);
+
+    // Gets the active rate divider
+    int getRateDivider() const;
+
+    // Stops the render thread, initializes the engine for the current host rate
+    // and block size and restarts
+    void initialize();
+
+    // Starts the render thread for the current block size if a latency is set
+    void start();
+
+    // Stops the render thread and applies the calls still queued
+    void stop();
+
+    // Calls call(engine) before the next block, on the render thread while it runs
+    template <typename F>
+    void post(F call)
+    {
+        static_assert(std::is_trivially_copyable<F>::value, "engine calls must capture by value");
+        static_assert(sizeof(F) <= RenderCommand::closureSize && alignof(F) <= 16, "engine call too large");
+
+        if (!thread.joinable())
+        {
+            call(engine);
+            return;
+        }
+
+        RenderCommand command;
+        command.invoke = &RenderAhead::invoke<F>;
+        command.frame = pushed.load(std::memory_order_relaxed);
+        new (command.closure) F(call);
+
+        if (!commands.push(command))
+            DSP::log("RenderAhead: command queue full, message dropped");
+    }
+
+    // Next sample block: renders it or hands the input to the render thread
+    // and fetches the block rendered latency blocks ago
+    void process(DSPBuffer &cutoff, DSPBuffer &resonance, DSPBuffer &amplitude);
+
+    // Output of the last processed block
+    const DSPBuffer &getOutputL() const;
+    const DSPBuffer &getOutputR() const;
+
+private:
+    // Replays a queued call
+    template <typename F>
+    static void invoke(PolyVoice *engine, const void *closure)
+    {
+        (*static_cast<const F *>(closure))(engine);
+    }
+
+    // Render thread main loop
+    void renderLoop();
+
+    // Applies the queued calls up to the given frame
+    void applyCommands(unsigned long frame);
+
+    // Renders a block on the DSP thread at the engine rate and resamples it to the host rate
+    void processResampled(DSPBuffer &cutoff, DSPBuffer &resonance, DSPBuffer &amplitude);
+
+    // True if the engine renders at another rate than the host
+    bool isResampled() const { return divider > 1; }
+
+    // Engine sample rate and block size for the current host rate and block size
+    dsp_float getEngineRate() const { return DSP::sampleRate / divider; }
+    size_t getEngineBlockSize() const { return DSP::blockSize / divider; }
+
+    PolyVoice *engine;
+    int latency = 0;
+    bool engineInitialized = false; // The engine has a sound to keep on the next initialize
+
+    // Internal rate
+    int divider = 1;               // Active rate divider
+    int requestedDivider = 1;      // Rate divider of the next initialize
+    DSPBuffer engineCutoff;        // Cutoff input at the engine rate
+    DSPBuffer engineResonance;     // Resonance input at the engine rate
+    DSPBuffer engineAmplitude;     // Amplitude input at the engine rate
+    DSPBuffer resampledL;          // Output left at the host rate, all channels
+    DSPBuffer resampledR;          // Output right at the host rate, all channels
+    HalfbandUpsampler upsampler;   // Half rate to host rate
+
+    // Frames in flight, indexed by frame number modulo size
+    std::vector<RenderFrame> frames;
+
+    // Calls from the control thread
+    SpscRing<RenderCommand> commands;
+
+    // Output of the last block while rendering ahead
+    DSPBuffer silence;
+    const DSPBuffer *outputL = nullptr;
+    const DSPBuffer *outputR = nullptr;
+
+    std::atomic<unsigned long> pushed{0};   // Frames handed to the render thread
+    std::atomic<unsigned long> rendered{0}; // Frames finished by the render thread
+    unsigned long consumed = 0;             // Frames taken by the DSP thread
+    unsigned long underruns = 0;            // Blocks the render thread missed
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // Parking
+    std::atomic<bool> parked{false};
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+};
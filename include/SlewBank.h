@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "DSP.h"
+#include "DSPBuffer.h"
+#include "DSPObject.h"
+#include "dsp_types.h"
+
+// The SlewBank smooths a fixed set of parameters with linear slews in one
+// pass per block. process advances all channels over a span and leaves a
+// start value and a per sample step per channel, a kernel evaluates
+// start + step * (i + 1) for the i-th sample of the span or render writes
+// the ramp into a buffer.
+class SlewBank : public DSPObject
+{
+public:
+    // Ctor: number of channels and slew time in milliseconds
+    SlewBank(size_t channels, dsp_float ms);
+
+    // Initializes the bank, all channels jump to 0
+    void initialize() override;
+
+    // Sets the slew time in milliseconds, 0 applies new targets at once
+    void setSlewTime(dsp_float ms);
+
+    // Gets the slew time in milliseconds
+    dsp_float getSlewTime() const;
+
+    // Sets a new target of a channel (starts smoothing)
+    void setTarget(size_t channel, dsp_float value);
+
+    // Jumps a channel to value without slewing
+    void reset(size_t channel, dsp_float value);
+
+    // Advances all channels over the next samples
+    void process(size_t samples);
+
+    // Writes the ramp of a channel over the last processed span into buffer [begin, end)
+    void render(size_t channel, DSPBuffer &buffer, size_t begin, size_t end) const;
+
+    // Value of a channel at the start of the last processed span
+    dsp_float getStart(size_t channel) const { return start[channel]; }
+
+    // Per sample increment of a channel within the last processed span
+    dsp_float getStep(size_t channel) const { return step[channel]; }
+
+    // Value of a channel at the end of the last processed span
+    dsp_float get(size_t channel) const { return current[channel]; }
+
+    // Target of a channel
+    dsp_float getTarget(size_t channel) const { return target[channel]; }
+
+    // True if no channel is on its way to its target
+    bool isIdle() const { return active == 0; }
+
+private:
+    // Calculates the samples for the current samplerate
+    void calcSamples();
+
+    dsp_float slewTime;
+    dsp_float slewSamples = 0.0;
+
+    // Channel state as separate arrays, the block pass runs over each of them in a row
+    std::vector<dsp_float> current;   // Value reached
+    std::vector<dsp_float> target;    // Target value
+    std::vector<dsp_float> increment; // Per sample increment of the slew
+    std::vector<dsp_float> remaining; // Samples left to the target
+    std::vector<dsp_float> start;     // Value at the start of the last span
+    std::vector<dsp_float> step;      // Per sample increment within the last span
+    size_t active = 0;                // Channels on their way
+};
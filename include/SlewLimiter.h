@@ -2,6 +2,7 @@
 
 #include "DSP.h"
 #include "DSPObject.h"
+#include "VoiceOptions.h"
 #include "dsp_types.h"
 
 class SlewLimiter : public DSPObject
@@ -19,28 +20,42 @@ public:
     // Sets the slew time in milliseconds
     void setSlewTime(double ms);
 
+    // Sets the curve, takes effect with the next target
+    void setMode(SlewMode value);
+
     // Advance one sample
     dsp_float process();
 
+    // Advances samples at once, returns the value at the end of the span
+    dsp_float processBlock(size_t samples);
+
+    // Jumps to value without slewing
+    void reset(dsp_float value);
+
     // Restarts the process
     void restart();
 
     // Slew is idle (has target value)
-    bool isIdle() { return idle; }
+    bool isIdle() const { return idle; }
 
     // Gets the current slew status
     double get() const { return current; }
 
+    // Gets the target
+    double getTarget() const { return target; }
+
 private:
     // Calculates the samples for current samplerate
     void calcSamples();
 
-    size_t samplerate;
-    size_t slewSamples;
+    dsp_float samplerate;
+    size_t slewSamples = 0;
     size_t remaining = 0;
     dsp_float current = 0.0;
     dsp_float target = 0.0;
-    dsp_float step = 0.0;
-    bool idle;
+    dsp_float step = 0.0;        // Per sample increment, linear
+    dsp_float coefficient = 0.0; // Per sample decay of the distance, exponential
+    bool idle = true;
     dsp_float slewTime;
+    SlewMode mode = SlewMode::Linear;
 };
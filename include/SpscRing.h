@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// The SpscRing is a lock-free ring buffer between exactly one producer
+// and one consumer thread. The capacity is rounded up to a power of two,
+// push fails when the ring is full and nothing is ever allocated after
+// construction.
+template <typename T>
+class SpscRing
+{
+public:
+    // Ctor: at least capacity elements
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+
+        while (size < capacity)
+            size <<= 1;
+
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer: appends an element, false if the ring is full
+    bool push(const T &item)
+    {
+        size_t tail = writeIndex.load(std::memory_order_relaxed);
+
+        if (tail - readIndex.load(std::memory_order_acquire) > mask)
+            return false;
+
+        items[tail & mask] = item;
+        writeIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: the oldest element or nullptr if the ring is empty
+    T *front()
+    {
+        size_t head = readIndex.load(std::memory_order_relaxed);
+
+        if (head == writeIndex.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &items[head & mask];
+    }
+
+    // Consumer: removes the element returned by front
+    void pop()
+    {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Gets the number of elements, exact only on the consumer side
+    size_t size() const
+    {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask = 0;
+
+    // Producer and consumer positions on their own cache lines
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "ADSR.h"
+#include "FrozenWavetable.h"
+#include "LFO.h"
+#include "ModMatrix.h"
 #include "ParamFader.h"
+#include "SlewBank.h"
+#include "SlewLimiter.h"
 #include "VoiceOptions.h"
+#include "VoiceParameters.h"
 #include "NoiseGenerator.h"
+#include "Oversampler.h"
 #include "SineWavetable.h"
 #include "SawWavetable.h"
 #include "TriangleWavetable.h"
@@ -15,6 +23,7 @@
 #include "ModuloWavetable.h"
 #include "BitWavetable.h"
 #include "KorgonFilter.h"
+#include "VoiceArena.h"
 #include "DSP.h"
 #include "DSPObject.h"
 #include "dsp_types.h"
@@ -32,7 +41,7 @@ public:
     // Constructor: requires two Oscillator pointers and the global sample rateSample
     Voice();
 
-    // Destructor: deletes both oscillator instances
+    // Destructor: the components are destroyed with the arena
     ~Voice();
 
     // Initializes the DSP object
@@ -51,12 +60,44 @@ public:
     // Sets the fine tunig for the modulator
     void setFineTune(dsp_float fine);
 
-    // Sets the frequency of oscillator 1/carrier
+    // Sets the frequency of oscillator 1/carrier, an awake voice glides to it within the glide time
     void setFrequency(dsp_float f);
 
+    // Sets the pitch bend in semi tones, smoothed over the bend time
+    void setPitchBend(dsp_float semitones);
+
+    // Sets the portamento time in ms and its curve, 0 jumps to a new note
+    void setGlide(dsp_float ms, SlewMode mode);
+
+    // Sets the time in ms a pitch bend change is smoothed over
+    void setBendTime(dsp_float ms);
+
+    // True if the pitch glides or a pitch bend change is smoothed
+    bool isGliding() const;
+
+    // Sets the time in ms oscillator mix, noise mix, modulation index and detune
+    // changes are smoothed over, 0 applies them at once
+    void setSmoothTime(dsp_float ms);
+
+    // True if a parameter change is smoothed
+    bool isSmoothing() const;
+
+    // Gets a snapshot of the sound parameters, smoothed parameters at their targets
+    VoiceParameters getParameters() const;
+
+    // Applies a snapshot in one call, only the parameters that differ are set
+    void setParameters(const VoiceParameters &parameters);
+
+    // Applies the parameters of a snapshot that differ from a previous snapshot
+    void setParameters(const VoiceParameters &parameters, const VoiceParameters &previous);
+
     // Sets the number of voices
     void setNumVoices(int count);
 
+    // Plays a paraphonic chord, pitches in semi tones relative to the voice frequency. The notes share
+    // the unison oscillators, the filter and the envelopes. Fewer than two notes end the chord
+    void setChord(const dsp_float *semitones, int count);
+
     // Sets the volume level of the oscillators
     void setOscillatorMix(dsp_float mix);
 
@@ -69,6 +110,13 @@ public:
     // Assigns the modulator oscillator
     void setModulatorOscillatorType(ModulatorOscillatorType oscillatorType);
 
+    // Creates the oscillators of a carrier and a modulator type ahead of a switch to them,
+    // a switch within a block then only swaps the oscillators
+    void prepareOscillators(CarrierOscillatiorType carrierType, ModulatorOscillatorType modulatorType);
+
+    // Creates the oscillators of every type, for parameter sources that may switch to any of them
+    void prepareAllOscillators();
+
     // Changes the current noise type (white or pink)
     void setNoiseType(NoiseType type);
 
@@ -93,6 +141,76 @@ public:
     // Sets the filter drive
     void setFilterDrive(dsp_float value);
 
+    // Sets the amplitude a VCA outside the voice applies to its output, without the internal
+    // envelopes idle detection measures the output at this amplitude. nullptr for full amplitude
+    void setExternalAmplitude(DSPBuffer *buffer);
+
+    // Opens or closes the note gate; opening the gate wakes an idle voice
+    // and starts the envelopes, closing it releases them
+    void setGate(bool open);
+
+    // Enables the internal amplitude and filter envelopes driven by the gate
+    void setEnvelopesEnabled(bool enabled);
+
+    // Sets a parameter of the amplitude envelope (VCA)
+    void setAmpEnvelope(EnvelopeParam param, dsp_float value);
+
+    // Sets a parameter of the filter envelope, its output is added to the cutoff in Hz
+    void setFilterEnvelope(EnvelopeParam param, dsp_float value);
+
+    // Sets the key velocity 0 - 1, a modulation source
+    void setVelocity(dsp_float value);
+
+    // Routes a modulation source to a destination, amount 0 removes the route
+    void setModulation(ModSource source, ModDestination destination, dsp_float amount);
+
+    // Sets a parameter of the modulation LFO
+    void setModLfo(LFOParam param, dsp_float value);
+
+    // Sets the samples between two evaluations of the modulation matrix
+    void setControlRate(int samples);
+
+    // True if modulation is routed, the chain then runs per control step
+    bool isModulated() const;
+
+    // Schedules a parameter change at a sample offset within the next block,
+    // offset 0 applies it at once
+    void schedule(VoiceEventType type, dsp_float value, size_t offset);
+
+    // Schedules a paraphonic chord at a sample offset within the next block,
+    // offset 0 applies it at once
+    void scheduleChord(const dsp_float *semitones, int count, size_t offset);
+
+    // True if scheduled events are pending for the next block
+    bool hasEvents() const;
+
+    // Sets the quality settings, they limit the parameters without changing them
+    void setQuality(const VoiceQuality &value);
+
+    // Sets the tile size in samples the voice chain runs on, 0 runs each stage over the whole block
+    void setTileSize(int samples);
+
+    // Enables freezing: a carrier and modulator setup that stays static for a while
+    // is baked into one band-limited table and played with a single table read
+    void setFreezeEnabled(bool enabled);
+
+    // True if the oscillators play the frozen table
+    bool isFrozen() const;
+
+    // Runs the mixer with its feedback and the filter at 1, 2 or 4 times the sample rate against
+    // aliasing, the oscillators stay at the sample rate. Oversampling delays the voice by about
+    // 31 samples at 2x and 47 samples at 4x
+    void setOversampling(int factor);
+
+    // Gets the oversampling factor
+    int getOversampling() const;
+
+    // True if the voice is sleeping and only outputs silence
+    bool isIdle();
+
+    // Puts the voice to sleep immediately
+    void sleep();
+
     // Next sample block generation
     void computeSamples();
 
@@ -100,6 +218,46 @@ public:
     DSPBuffer mixBufferR; // Mixing buffer right channel
 
 private:
+    // The lane renderer works on the voice state directly
+    friend class VoiceLanes;
+
+    // Prepares the next block with all pending events applied at its start and
+    // generates the envelopes, returns false if the voice sleeps
+    bool beginBlock();
+
+    // Outputs silence for a sleeping voice, returns false if the voice sleeps
+    bool prepareBlock();
+
+    // Renders the samples [start, end) with the current parameters, per tile or control step
+    void renderSpan(size_t start, size_t end, size_t tile);
+
+    // Generates the envelopes and the filter envelope cutoff for the samples [start, end)
+    void generateEnvelopes(size_t start, size_t end);
+
+    // Applies parameter fades, the amplitude envelope and idle detection after rendering
+    void endBlock();
+
+    // Stages needed for the next block, stages that cannot affect the output are skipped
+    struct BlockPlan
+    {
+        bool modulator = true; // Modulator is heard or modulates the carrier
+        bool feedback = true;  // A feedback path is active
+        bool noise = false;    // Noise is mixed in
+        bool filter = true;    // Cutoff is not fully open
+        bool mono = false;     // Both channels are identical, only the left one is rendered
+        bool frozen = false;   // The frozen table plays carrier and modulator
+    };
+
+    // Derives the stages needed for the samples [start, end) from the parameters
+    void planBlock(size_t start, size_t end);
+
+    // Plays the frozen table in the samples of the current span if it still matches
+    void planFreeze();
+
+    size_t tileSize = 0; // Samples per tile, 0 for whole block stages
+
+    BlockPlan plan; // Plan of the current block
+
     WavetableOscillator *carrier;      // Carrier oscillator (may be modulated)
     WavetableOscillator *modulator;    // Modulator oscillator (for FM or sync)
     WavetableOscillator *carrierTmp;   // Carrier oscillator (may be modulated)
@@ -107,6 +265,20 @@ private:
 
     dsp_float frequency = 0.0; // Current frequency
 
+    // Glide and pitch bend in octaves, the oscillator kernels ramp the
+    // frequency per tile from one evaluation of the slews
+    void setOscillatorFrequency(dsp_float f, dsp_float ratio);
+    void rampPitch(size_t samples);
+    void settlePitch();
+
+    SlewLimiter glide{0.0};           // Note pitch in octaves (log2 Hz)
+    SlewLimiter bend{bendTime};       // Pitch bend in octaves
+    dsp_float currentFrequency = 0.0; // Unmodulated oscillator frequency at the current tile
+    bool pitchRamping = false;        // The oscillators ramp their frequency
+
+    // Default smoothing of pitch bend changes in ms
+    static constexpr dsp_float bendTime = 10.0;
+
     dsp_float modulationIndex = 0;       // FM depth: how much modulator modulates carrier
 
     dsp_float oscmix = 0.0;   // Mix carrier <=> modulator
@@ -117,51 +289,274 @@ private:
     dsp_float pulseWidth = 0.5; // Pulse width square oscillator
     int pitchOffset = 0;        // Pitch offset modulator
     dsp_float fineTune = 0;     // Fine tune modulator
+    dsp_float drive = 0.0;      // Filter drive as set
+
+    CarrierOscillatiorType carrierType = CarrierOscillatiorType::Saw;      // Selected carrier
+    ModulatorOscillatorType modulatorType = ModulatorOscillatorType::Sine; // Selected modulator
+    NoiseType noiseType = NoiseType::White;                                // Selected noise
+
+    // Envelope parameters as set, indexed by EnvelopeParam
+    dsp_float ampEnvelope[EnvelopeParamCount];
+    dsp_float filterEnvelope[EnvelopeParamCount];
+
+    // Parameters smoothed by the slew bank, the values above follow it per tile
+    enum class SmoothedParam
+    {
+        OscMix,
+        NoiseMix,
+        ModIndex,
+        Detune,
+        Count
+    };
+
+    // Passes a parameter change to the slew bank, false if it applies at once
+    bool smoothParam(SmoothedParam param, dsp_float value);
 
-    // Oscillators
-    NoiseGenerator *noise = new NoiseGenerator(); // Noise generator
-    SineWavetable *sineCarrier = new SineWavetable();
-    SineWavetable *sineModulator = new SineWavetable();
-    SawWavetable *sawCarrier = new SawWavetable();
-    SawWavetable *sawModulator = new SawWavetable();
-    SquareWavetable *squareCarrier = new SquareWavetable();
-    SquareWavetable *squareModulator = new SquareWavetable();
-    TriangleWavetable *trianlgeCarrier = new TriangleWavetable();
-    TriangleWavetable *triangleModulator = new TriangleWavetable();
-    HarmonicClusterWavetable *clusterCarrier = new HarmonicClusterWavetable();
-    HarmonicClusterWavetable *clusterModulator = new HarmonicClusterWavetable();
-    FibonacciWavetable *fibonacciCarrier = new FibonacciWavetable();
-    FibonacciWavetable *fibonacciModulator = new FibonacciWavetable();
-    MirrorWavetable *mirrorCarrier = new MirrorWavetable();
-    MirrorWavetable *mirrorModulator = new MirrorWavetable();
-    ModuloWavetable *moduloCarrier = new ModuloWavetable();
-    ModuloWavetable *moduloModulator = new ModuloWavetable();
-    BitWavetable *bitModulator = new BitWavetable();
+    // Advances the smoothed parameters over the samples [start, end), mixer gains
+    // and modulation index ramp within, detune steps per tile
+    void smoothParams(size_t start, size_t end);
+
+    // Puts the smoothed parameters on their targets at once
+    void settleParams();
+
+    SlewBank smoother{static_cast<size_t>(SmoothedParam::Count), 0.0};
+    bool smoothing = false; // The last tile ramped, the next one holds the reached values
+
+    // Number of selectable oscillator types
+    static constexpr int carrierTypeCount = 8;
+    static constexpr int modulatorTypeCount = 9;
+
+    // Gets the carrier of a type, constructs it in the arena when first selected
+    WavetableOscillator *getCarrier(CarrierOscillatiorType type);
+
+    // Gets the modulator of a type, constructs it in the arena when first selected
+    WavetableOscillator *getModulator(ModulatorOscillatorType type);
+
+    // Takes the tables of every oscillator type, the oscillators selected later are
+    // created with them and initialize without file access or table generation
+    void loadTables();
+
+    // Arena holding filter, noise generator and the oscillators in use
+    VoiceArena arena;
+
+    // Shared tables of every oscillator type at the current sample rate
+    std::shared_ptr<const WavetableSet> carrierTables[carrierTypeCount];
+    std::shared_ptr<const WavetableSet> modulatorTables[modulatorTypeCount];
+
+    // Oscillators by type, nullptr until selected
+    WavetableOscillator *carriers[carrierTypeCount] = {};
+    WavetableOscillator *modulators[modulatorTypeCount] = {};
+
+    // Noise generator
+    NoiseGenerator *noise;
 
     // Multi mode filter
-    KorgonFilter *filter = new KorgonFilter();
-
-    // DSP working vars
-    dsp_float carrierLeft, carrierRight;
-    dsp_float modLeft, modRight;
-    dsp_float mixL, mixR;
-    dsp_float amp_carrier;
-    dsp_float amp_modulator;
-    dsp_float amp_oscmix;
-    dsp_float amp_osc_noise;
-    dsp_float amp_noise;
+    KorgonFilter *filter;
+
+    // True after initialize, oscillators created later are initialized on creation
+    bool componentsInitialized = false;
+
+    // Equal power mixer gains
+    struct MixGains
+    {
+        dsp_float carrier = 1.0;   // Carrier in the oscillator mix
+        dsp_float modulator = 0.0; // Modulator in the oscillator mix
+        dsp_float osc = 1.0;       // Oscillators in the noise mix
+        dsp_float noise = 0.0;     // Noise in the noise mix
+    };
+
+    MixGains mixTarget; // Gains for the current oscmix/noisemix
+    MixGains mixGains;  // Gains reached at the end of the last block
+    MixGains mixStart;  // Gains at the start of the current block
+    MixGains mixStep;   // Per sample increment within the current block
+
+    // Starts the per block ramp of the mixer gains towards their targets
+    void prepareMixGains();
+
+    // Ramps the mixer gains from offset to the end of the block towards their targets
+    void retargetMixGains(size_t offset);
+
+    // Mixer kernel for the samples [start, end)
+    using MixKernel = void (*)(Voice *, size_t, size_t);
+
+    template <bool Modulator, bool Feedback, bool Noise, bool Mono>
+    static void mixKernel(Voice *voice, size_t start, size_t end);
+
+    // Mixer kernels indexed by [mono][modulator][feedback][noise]
+    static const MixKernel mixKernels[2][2][2][2];
+
+    // Inputs and outputs of the mixer kernel, at the sample rate or oversampled
+    struct MixBuffers
+    {
+        const dsp_float *carrierL = nullptr;
+        const dsp_float *carrierR = nullptr;
+        const dsp_float *modulatorL = nullptr;
+        const dsp_float *modulatorR = nullptr;
+        const dsp_float *noise = nullptr;
+        dsp_float *outL = nullptr;
+        dsp_float *outR = nullptr;
+        dsp_float gainScale = 1.0; // Gain steps per sample, 1 / oversampling
+    };
+
+    MixBuffers mixBuffers; // Buffers of the current span
+
+    // Channels of the oversampler, the mix output uses the carrier channels of the decimators
+    enum OversampledChannel
+    {
+        CarrierLeft,
+        CarrierRight,
+        ModulatorLeft,
+        ModulatorRight,
+        NoiseChannel,
+        OversampledChannelCount
+    };
+
+    // Allocates the oversampled buffers for the current factor, none at factor 1
+    void initializeOversampling();
+
+    // Upsamples the oscillator and noise outputs of the samples [start, end) the mixer reads
+    void upsampleSources(size_t start, size_t end);
+
+    // Downsamples the oversampled mix of the samples [start, end) into the mix buffers
+    void downsampleMix(size_t start, size_t end);
+
+    int oversampling = 1;                           // Oversampling factor of mixer and filter
+    Oversampler oversampler;                        // Sample rate to oversampled rate and back
+    DSPBuffer oversampled[OversampledChannelCount]; // Upsampled oscillator and noise outputs
+    DSPBuffer oversampledMixL;                      // Mix and filter output left at the oversampled rate
+    DSPBuffer oversampledMixR;                      // Mix and filter output right at the oversampled rate
+    unsigned oversampledChannels = 0;               // Channels upsampled in the last tile, one bit each
 
     // Feedback
     dsp_float lastSampleCarrierLeft;
     dsp_float lastSampleCarrierRight;
     dsp_float lastSampleModulatorLeft;
     dsp_float lastSampleModulatorRight;
-    dsp_float feedbackAmountCarrier = 0.0;
-    dsp_float feedbackAmountModulator = 0.0;
+    dsp_float feedbackAmountCarrier = 0.0;   // Feedback in effect
+    dsp_float feedbackAmountModulator = 0.0; // Feedback in effect
+    dsp_float feedbackCarrier = 0.0;         // Feedback as set
+    dsp_float feedbackModulator = 0.0;       // Feedback as set
 
     // Number of voices
     int numVoices = 1;
 
+    // Paraphonic chord, pitch ratios relative to the voice frequency
+    dsp_float chordRatios[WavetableOscillator::maxVoices];
+    int chordSize = 0;
+
+    // Quality settings
+    VoiceQuality quality;
+
+    // Unison voices in effect
+    int getUnison() const;
+
+    // Feedback in effect, the feedback paths are off on low quality
+    void applyFeedback();
+
+    // Applies the quality settings to an oscillator
+    void applyQuality(WavetableOscillator *osc);
+
     // Parameter change fader
     ParamFader paramFader;
+
+    // A static oscillator setup the frozen table is valid for
+    struct FreezeKey
+    {
+        const WavetableOscillator *carrier = nullptr;   // Carrier in use, nullptr for none
+        const WavetableOscillator *modulator = nullptr; // Modulator in use
+        dsp_float index = 0.0;                          // Modulation index
+        dsp_float ratio = 1.0;                          // Modulator frequency / carrier frequency
+        dsp_float gain = 0.0;                           // Modulator gain relative to the carrier gain
+        dsp_float offset = 0.0;                         // Modulator phase - ratio * carrier phase
+
+        // True if both describe the same waveform
+        bool matches(const FreezeKey &other) const;
+    };
+
+    // Gets the setup of the oscillators, false if it cannot be frozen
+    bool getFreezeKey(FreezeKey &key) const;
+
+    // Follows the setup once per block: builds the frozen table after it stayed
+    // static for the freeze delay and drops it as soon as a parameter moves
+    void updateFreeze();
+
+    FrozenWavetable frozen;      // Carrier and modulator baked into one table
+    FreezeKey frozenKey;         // Setup of the frozen table
+    bool freezeEnabled = false;  // Freezing is enabled
+    long freezeCountdown = 0;    // Samples the setup has to stay static before freezing
+
+    // Time in ms a setup has to stay static before it is frozen
+    static constexpr dsp_float freezeDelay = 50.0;
+
+    // Envelopes
+    static void setEnvelope(ADSR &env, EnvelopeParam param, dsp_float value);
+    void applyAmpEnvelope();
+
+    ADSR ampEnv;                      // Amplitude envelope (VCA)
+    ADSR filterEnv;                   // Filter envelope added to the cutoff
+    DSPBuffer envCutoffBuffer;        // Cutoff input + filter envelope
+    DSPBuffer *cutoffInput = nullptr; // External cutoff input, nullptr for none
+    bool envelopesEnabled = false;    // Envelopes active
+
+    // Modulation matrix
+    void routeCutoff();
+    void resetModulation();
+    void modulate(size_t start, size_t end);
+
+    ModMatrix modMatrix;                            // Routes of the modulation sources
+    LFO modLfo;                                     // Modulation LFO
+    DSPBuffer modCutoffBuffer;                      // Cutoff input scaled by the cutoff modulation
+    dsp_float modulation[ModDestinationCount] = {}; // Destination values of the current control step
+    dsp_float cutoffFactor = 1.0;                   // Cutoff scale reached at the last control step
+    dsp_float velocity = 1.0;                       // Key velocity
+    dsp_float key = 0.0;                            // Octaves relative to middle C
+    size_t controlRate = 16;                        // Samples per control step
+
+    // A parameter change scheduled at a sample offset within the next block
+    struct VoiceEvent
+    {
+        size_t offset;       // Sample offset
+        VoiceEventType type; // Parameter
+        dsp_float value;     // New value
+    };
+
+    // Applies a parameter change
+    void applyEvent(const VoiceEvent &event);
+
+    // Applies the events due at offset, returns the offset of the next event or the block size
+    size_t applyEvents(size_t offset);
+
+    static constexpr size_t maxEvents = 64; // Events per block, more are applied at once
+
+    VoiceEvent events[maxEvents]; // Pending events sorted by offset
+    size_t eventCount = 0;        // Number of pending events
+    size_t eventIndex = 0;        // Next event to apply
+
+    // The notes of a scheduled chord, a Chord event carries its index
+    struct PendingChord
+    {
+        dsp_float semitones[WavetableOscillator::maxVoices];
+        int count;
+    };
+
+    static constexpr size_t maxChords = 8; // Chords per block, more are applied at once
+
+    PendingChord chords[maxChords]; // Notes of the pending Chord events
+    size_t chordCount = 0;          // Number of pending chords
+    bool noiseGenerated = false;  // Noise block generated for the current block
+
+    // Idle detection
+    void wake();
+    void wakeOnChange();
+    void detectSilence();
+
+    bool idle = false;                       // True if the voice sleeps
+    bool gateOpen = true;                    // Note gate, open by default for patches without gate messages
+    DSPBuffer *externalAmplitude = nullptr;  // Amplitude of a VCA outside the voice or nullptr
+
+    // Peak level below which the voice is regarded as silent (~ -100 dB)
+    static constexpr dsp_float silenceThreshold = 1e-5;
+
+    // Level a release tail is cut at when tails are off (-60 dB)
+    static constexpr dsp_float tailThreshold = 1e-3;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// The VoiceArena class places the components of a voice in one contiguous,
+// cache line aligned memory block. Objects are constructed on demand and
+// destroyed in reverse order together with the arena.
+class VoiceArena
+{
+public:
+    // Cache line size, every object starts on its own line
+    static constexpr size_t alignment = 64;
+
+    // Rounds a size up to whole cache lines
+    static constexpr size_t align(size_t size)
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Ctor: reserves capacity bytes
+    explicit VoiceArena(size_t capacity);
+
+    // Dtor: destroys all objects and releases the memory
+    ~VoiceArena();
+
+    VoiceArena(const VoiceArena &) = delete;
+    VoiceArena &operator=(const VoiceArena &) = delete;
+
+    // Constructs an object of type T in the arena
+    template <typename T>
+    T *create()
+    {
+        T *object = new (allocate(sizeof(T))) T();
+        objects.push_back({object, &VoiceArena::destroy<T>});
+        return object;
+    }
+
+    // Gets the number of bytes in use
+    size_t getUsed() const;
+
+private:
+    // Reserves size bytes aligned to a cache line
+    void *allocate(size_t size);
+
+    // Calls the destructor of an arena object
+    template <typename T>
+    static void destroy(void *object)
+    {
+        static_cast<T *>(object)->~T();
+    }
+
+    // An object living in the arena
+    struct Entry
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    unsigned char *memory = nullptr; // The memory block
+    size_t capacity = 0;             // Size of the memory block
+    size_t used = 0;                 // Bytes in use
+    std::vector<Entry> objects;      // Objects in construction order
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include "Voice.h"
+#include "dsp_types.h"
+
+// Number of voices rendered side by side: one AVX register of floats,
+// otherwise one NEON/SSE register of floats or two of doubles
+#if defined(__AVX__) && !defined(USE_DOUBLE_PRECISION)
+constexpr int LaneCount = 8;
+#else
+constexpr int LaneCount = 4;
+#endif
+
+// The VoiceLanes class renders up to LaneCount voices at once. The state of
+// the voices is laid out lane by lane, so every stage (modulator, carrier,
+// mixer, filter) advances all voices with one instruction stream. Voices may
+// have different parameters, lanes without an active voice are masked out.
+class VoiceLanes
+{
+public:
+    // Initializes the lane interleaved work buffers for the sample rate and block size of the voices
+    void initialize(dsp_float rate, size_t size);
+
+    // Renders count (<= LaneCount) voices into their mix buffers
+    void render(Voice *const *voices, int count);
+
+private:
+    // Stages, lane interleaved buffers hold [sample * LaneCount + lane]
+    void renderModulators(Voice *const *lane, int active);
+    void renderCarriers(Voice *const *lane, int active);
+    void renderMixers(Voice *const *lane, int active);
+    void renderFilters(Voice *const *lane, int active);
+
+    std::vector<dsp_float> modBuffer;    // Modulator output
+    std::vector<dsp_float> leftBuffer;   // Carrier, mix and filter left
+    std::vector<dsp_float> rightBuffer;  // Carrier, mix and filter right
+    std::vector<dsp_float> noiseBuffer;  // Noise input of the mixers
+    std::vector<dsp_float> cutoffBuffer; // Cutoff input of the filters
+    std::vector<dsp_float> resoBuffer;   // Resonance input of the filters
+
+    dsp_float sampleRate = 0.0; // Sample rate of the voices
+    size_t blockSize = 0;       // Block size of the voices
+};
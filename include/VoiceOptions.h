@@ -51,4 +51,101 @@ enum class FilterMode
     LPF12,
     HPF12,
     BPF12
-};
\ No newline at end of file
+};
+
+// Envelope parameters addressable on the voices' envelopes
+enum class EnvelopeParam
+{
+    Attack,       // Attack time in ms
+    Decay,        // Decay time in ms
+    Sustain,      // Sustain level 0 - 1
+    Release,      // Release time in ms
+    AttackShape,  // Attack curve -1 - 1
+    ReleaseShape, // Release curve -1 - 1
+    Gain,         // Output gain
+    OneShot       // One shot mode 0/1
+};
+
+// Modulation sources of a voice
+enum class ModSource
+{
+    Lfo,      // Modulation LFO of the voice
+    Envelope, // Amplitude envelope
+    Velocity, // Key velocity 0 - 1
+    Key       // Key position in octaves relative to middle C
+};
+
+// Modulation destinations of a voice
+enum class ModDestination
+{
+    Cutoff,   // Filter cutoff in octaves
+    Pitch,    // Oscillator pitch in semi tones
+    ModIndex, // Added to the modulation index
+    Detune,   // Added to the detune 0 - 1
+    OscMix,   // Added to the oscillator mix 0 - 1
+    Noise     // Added to the noise mix 0 - 1
+};
+
+// Number of modulation sources and destinations
+constexpr int ModSourceCount = 4;
+constexpr int ModDestinationCount = 6;
+
+// Parameters of the voices' modulation LFO
+enum class LFOParam
+{
+    Frequency,  // Rate in Hz
+    Type,       // Waveform index as in lfo~
+    Shape,      // Ramp curve -1 - 1
+    PulseWidth, // Square pulse width
+    Smooth,     // Smoothing 0 - 1
+    Offset,     // Added to the output
+    Depth       // Output scale
+};
+
+// Parameters of the ensemble on the summed output
+enum class EnsembleParam
+{
+    Mix,   // Wet share 0 - 1, 0 bypasses the ensemble
+    Rate,  // Rate of the slow LFO in Hz, the vibrato LFO runs ten times faster
+    Depth, // Delay modulation of the slow LFO in ms
+    Delay  // Center delay of the taps in ms
+};
+
+// Curves of a slew limiter
+enum class SlewMode
+{
+    Linear,     // Constant rate, reaches the target after the slew time
+    Exponential // One pole, 99.9 % of the way after the slew time, then snaps to the target
+};
+
+// Voice parameters that can be scheduled at a sample offset within a block
+enum class VoiceEventType
+{
+    Gate,             // Note gate 0/1
+    Frequency,        // Carrier frequency in Hz
+    Velocity,         // Key velocity 0 - 1
+    ModIndex,         // Modulation index
+    Detune,           // Detune 0 - 1
+    OscMix,           // Oscillator mix 0 - 1
+    NoiseMix,         // Noise mix 0 - 1
+    PitchOffset,      // Modulator offset in semi tones
+    FineTune,         // Modulator fine tune in cent
+    NumVoices,        // Unison voices
+    CarrierType,      // CarrierOscillatiorType index
+    ModulatorType,    // ModulatorOscillatorType index
+    Sync,             // Oscillator sync 0/1
+    FeedbackCarrier,  // Carrier feedback amount
+    FeedbackModulator, // Modulator feedback amount
+    PitchBend,         // Pitch bend in semi tones
+    Chord              // Index of a chord passed to Voice::scheduleChord
+};
+
+// Quality settings of a voice, lowered step by step under CPU pressure
+struct VoiceQuality
+{
+    bool tails = true;         // Release tails run down to silence, off cuts them at -60 dB
+    int maxUnison = 9;         // Upper limit of the unison voices
+    bool feedback = true;      // Oscillator feedback paths
+    bool saturation = true;    // Filter soft clipping
+    bool interpolation = true; // Linear interpolation of the wavetables
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "VoiceOptions.h"
+#include "dsp_types.h"
+
+// Number of envelope parameters
+constexpr int EnvelopeParamCount = 8;
+
+// Flat snapshot of the sound parameters of a voice. It is trivially copyable,
+// a preset is stored and recalled with a plain copy. Envelopes are indexed by
+// EnvelopeParam.
+struct VoiceParameters
+{
+    int carrierType = static_cast<int>(CarrierOscillatiorType::Saw);        // CarrierOscillatiorType index
+    int modulatorType = static_cast<int>(ModulatorOscillatorType::Sine);    // ModulatorOscillatorType index
+    int noiseType = static_cast<int>(NoiseType::White);                     // NoiseType index
+    int numVoices = 1;                                                      // Unison voices
+    int pitchOffset = 0;                                                    // Modulator offset in semi tones
+    int sync = 0;                                                           // Oscillator sync 0/1
+    dsp_float modIndex = 0.0;                                               // Modulation index
+    dsp_float oscMix = 0.0;                                                 // Oscillator mix 0 - 1
+    dsp_float noiseMix = 0.0;                                               // Noise mix 0 - 1
+    dsp_float detune = 0.0;                                                 // Detune 0 - 1
+    dsp_float fineTune = 0.0;                                               // Modulator fine tune in cent
+    dsp_float feedbackCarrier = 0.0;                                        // Carrier feedback amount
+    dsp_float feedbackModulator = 0.0;                                      // Modulator feedback amount
+    dsp_float drive = 0.0;                                                  // Filter drive 0 - 1
+    dsp_float ampEnvelope[EnvelopeParamCount] = {10.0, 100.0, 0.7, 750.0, 0.0, 0.0, 1.0, 0.0};    // Amplitude envelope
+    dsp_float filterEnvelope[EnvelopeParamCount] = {10.0, 100.0, 0.7, 750.0, 0.0, 0.0, 1.0, 0.0}; // Filter envelope
+
+    // Blends two snapshots, amount 0 is from and 1 is to. Continuous parameters
+    // are interpolated linearly, discrete ones switch half way
+    static VoiceParameters morph(const VoiceParameters &from, const VoiceParameters &to, dsp_float amount);
+};
@@ -18,11 +18,12 @@ public:
     // Parameters:
     // - buffer: the target wavetable buffer (will be resized if needed)
     // - baseFrequency: the fundamental frequency (used to limit harmonics)
-    // - sampleRate: the system's sample rate
+    // - sampleRate: the sample rate the table is played at
     // - amplitudeFunc: user-supplied function that returns harmonic amplitudes
     // - harmonicBoost: 0 - 1 (optional aliasing)
     static void generateWavetable(DSPBuffer &buffer,
                                   dsp_float baseFrequency,
+                                  dsp_float sampleRate,
                                   AmplitudeFunction amplitudeFunc,
                                   dsp_float harmonicBoost = 0);
 };
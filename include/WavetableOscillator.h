@@ -13,24 +13,53 @@ struct WavetableVoice
 {
     dsp_float phase;
     dsp_float detune_ratio;
+    dsp_float pitch_ratio; // Chord pitch relative to the oscillator frequency, 1 in unison
     dsp_float amp_ratio;
     dsp_float gainL;
     dsp_float gainR;
 };
 
+// The band-limited tables of a waveform at one sample rate, shared by all
+// oscillators of the waveform and never changed once loaded
+struct WavetableSet
+{
+    dsp_float sampleRate = 0.0;                      // Sample rate the tables are built for
+    std::vector<double> baseFrequencies;             // Lowest frequency of each table
+    std::vector<std::unique_ptr<DSPBuffer>> buffers; // One table per frequency range
+};
+
 // Abstract base class for all wavetable-based oscillators
 class WavetableOscillator : public DSPObject
 {
 public:
-    // Initializes all wavetable buffers for multiple frequency ranges
+    // Maximum number of unison voices and chord notes
+    static constexpr int maxVoices = 9;
+
+    // Initializes the oscillator, takes the shared tables of the waveform at the
+    // oscillator's sample rate. They are loaded or generated by the first oscillator of the waveform
     void initialize() override;
 
+    // Takes the shared tables of the waveform at the oscillator's sample rate unless the
+    // oscillator has them already, the first oscillator of the waveform loads or generates them
+    void loadTables();
+
+    // Gets the tables shared by the oscillators of the waveform, nullptr before they are loaded
+    std::shared_ptr<const WavetableSet> getTables() const;
+
+    // Hands over the tables of another oscillator of the waveform, an initialize at their
+    // sample rate then takes them without file access or table generation
+    void setTables(std::shared_ptr<const WavetableSet> shared);
+
     // Sets the number of voices
     void setNumVoices(int count);
 
     // Sets the detune factor for the voices
     void setDetune(dsp_float value);
 
+    // Sets the pitch ratios of a paraphonic chord relative to the frequency, the unison voices
+    // take the notes in turn. Fewer than two notes play every voice at the frequency
+    void setChord(const dsp_float *ratios, int count);
+
     // Sets the desired oscillator frequency in Hertz
     void setFrequency(dsp_float value);
 
@@ -40,6 +69,10 @@ public:
     // Sets the fine tuning in cent
     void setFineTune(dsp_float value);
 
+    // Sets the per sample frequency ratio of the next renders, 1 for a steady pitch.
+    // The kernels ramp the frequency geometrically, a glide in the log frequency domain
+    void setFrequencyRamp(dsp_float ratio);
+
     // Gets the current frequency
     dsp_float getFrequency();
 
@@ -50,6 +83,10 @@ public:
     // This controls the intensity of the frequency modulation effect.
     void setModIndex(dsp_float index);
 
+    // Sets the per sample increment of the modulation index in the next renders, 0 for a steady index.
+    // The i-th sample of a render is modulated with index + step * (i + 1)
+    void setModIndexRamp(dsp_float step);
+
     // Returns true if the oscillator's phase wrapped during the last getSample() call
     bool hasWrapped();
 
@@ -59,6 +96,31 @@ public:
     // Resets the internal oscillator phase to 0.0.
     void resetPhase();
 
+    // Advances the phase by samples without rendering, keeps a skipped oscillator in time
+    void advancePhase(size_t samples);
+
+    // Gets the phase 0 - 1 of a single voice
+    dsp_float getPhase() const;
+
+    // Gets the per sample phase increment of a single voice
+    dsp_float getPhaseIncrement() const;
+
+    // Reads the wavetable of the current frequency at a phase, wrapped to 0 - 1
+    dsp_float lookup(dsp_float phase);
+
+    // Renders the samples [start, end) of the next block phase modulated by modL/modR,
+    // the kernel and the wavetable are selected per call
+    void render(const DSPBuffer &modL, const DSPBuffer &modR, size_t start, size_t end);
+
+    // Enables linear interpolation between table samples, off reads the nearest sample
+    void setInterpolation(bool enabled);
+
+    // True if the output is mono for a mono modulation input (single voice)
+    bool isMono() const;
+
+    // Renders the samples [start, end) of a mono oscillator into outBufferL only
+    void renderMono(const DSPBuffer &mod, size_t start, size_t end);
+
     // Buffer for modulation
     DSPBuffer modBufferL;
     DSPBuffer modBufferR;
@@ -80,33 +142,56 @@ protected:
     // Define the corresponding table size for each frequency range
     std::vector<size_t> tableSizes;
 
-    // One wavetable buffer per frequency band
-    std::vector<std::unique_ptr<DSPBuffer>> wavetableBuffers;
-
 private:
+    // The lane renderer works on the oscillator state directly
+    friend class VoiceLanes;
+
     // Next sample block generation
     static void processBlock(DSPObject *dsp);
 
+    // Render kernel specialised for table interpolation, unison, phase modulation and left channel only output
+    using RenderKernel = void (*)(WavetableOscillator *, const DSPBuffer &, const DSPBuffer &, size_t, size_t);
+
+    template <bool Interpolated, bool Unison, bool Modulated, bool Mono>
+    static void renderKernel(WavetableOscillator *osc, const DSPBuffer &modBufferL, const DSPBuffer &modBufferR,
+                             size_t start, size_t end);
+
+    // Render kernels indexed by [interpolated][unison][modulated]
+    static const RenderKernel kernels[2][2][2];
+
+    // Left channel only render kernels of a single voice indexed by [interpolated][modulated]
+    static const RenderKernel monoKernels[2][2];
+
     // Calculates the effective frequency based on base frequency,
     // pitch offset (in semitones), and fine-tuning (in cents).
     // Then updates the phase increment accordingly.
     void setCalculatedFrequency(dsp_float f);
 
+    // Gets the tables of the waveform at the oscillator's sample rate from the cache shared
+    // by all oscillators, the first request loads or generates them
+    std::shared_ptr<const WavetableSet> acquireTables();
+
     // Loads a wavetable
-    bool load();
+    bool load(WavetableSet &set) const;
 
     // Saves a wavetable
-    void save() const;
+    void save(const WavetableSet &set) const;
 
     // Select appropriate wavetable for the given frequency
     void selectTable(double frequency);
 
-    // Update detune on voices
-    void updateDetune();
+    // Selects the wavetable for the current frequency, a no-op if unchanged
+    void prepareTable();
+
+    // Spreads the voices of every chord note in pitch and stereo
+    void updateSpread();
 
     // The waveform name
     std::string waveformName;
 
+    // The tables of the waveform
+    std::shared_ptr<const WavetableSet> tables;
+
     // stores the last wavetable to prevent lookup when frequency did not change
     const DSPBuffer *selectedWaveTable = nullptr;
     size_t selectedWaveTableSize = 0;
@@ -119,6 +204,10 @@ private:
     // Voices detune
     dsp_float detune = 0.03;
 
+    // Paraphonic chord, pitch ratios relative to the frequency
+    dsp_float chordRatios[maxVoices];
+    int chordSize = 0;
+
     dsp_float frequency;           // The desired oscillator frequency in Hertz
     dsp_float calculatedFrequency; // The calculated FM frequency in Hertz
     int pitchOffset;               // offset in half tones
@@ -127,4 +216,7 @@ private:
     dsp_float phaseIncrement;      // Increment based on frquency and sample rate
     dsp_float currentPhase;        // Current phase of the oscillator in radians [0, 2π]
     bool wrapped = false;          // True when phase wrapped
+    bool interpolated = true;      // Linear interpolation between table samples
+    dsp_float frequencyRamp = 1.0; // Per sample frequency ratio, 1 for a steady pitch
+    dsp_float modIndexRamp = 0.0;  // Per sample modulation index increment, 0 for a steady index
 };
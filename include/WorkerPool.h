@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dsp_types.h"
+
+// The WorkerPool runs a batch of independent jobs on pinned real-time
+// worker threads. The calling thread takes part in the batch and returns
+// when all jobs are done. Jobs are claimed through a lock-free counter,
+// idle workers spin for a short time before they park on a condition.
+class WorkerPool
+{
+public:
+    // A job processes one argument of the batch
+    using Job = void (*)(void *arg);
+
+    // Ctor
+    WorkerPool();
+
+    // Dtor: stops the workers
+    ~WorkerPool();
+
+    // Starts count worker threads, pinned round robin to the given cpus (empty: no pinning)
+    void start(int count, const std::vector<int> &cpus);
+
+    // Stops and joins all worker threads
+    void stop();
+
+    // Gets the number of worker threads
+    int getWorkerCount() const;
+
+    // Sets the time in microseconds an idle worker spins before it parks
+    void setSpinTime(dsp_float us);
+
+    // Runs job for each of the count arguments and waits for completion
+    void run(Job job, void *const *args, int count);
+
+    // Pins the thread to a cpu (-1: no pinning) and raises it to real-time priority
+    static void configureThread(std::thread &thread, int cpu);
+
+private:
+    // Worker thread main loop
+    void workerLoop(int index);
+
+    // Claims and executes jobs of the given batch generation
+    void execute(uint32_t generation);
+
+    // Batch generation (upper 32 bits) and next job index (lower 32 bits)
+    std::atomic<uint64_t> work{0};
+
+    // Jobs of the current batch not yet finished
+    std::atomic<int> pendingJobs{0};
+
+    // Number of parked workers
+    std::atomic<int> parkedWorkers{0};
+
+    // Worker threads keep running while true
+    std::atomic<bool> running{false};
+
+    // Spin time in nanoseconds
+    std::atomic<long> spinNanos{500000};
+
+    // Current batch, published through work
+    std::atomic<Job> currentJob{nullptr};
+    std::atomic<void *const *> currentArgs{nullptr};
+    std::atomic<int> jobCount{0};
+
+    std::vector<std::thread> workers;
+
+    // Parking
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+};
@@ -11,6 +11,16 @@ inline dsp_float fast_tanh(dsp_float val)
     return val * (27.0 + val2) / (27.0 + 9.0 * val2);
 }
 
+// Branch free fast_tanh for vectorized loops, same result as fast_tanh
+inline dsp_float fast_tanh_select(dsp_float val)
+{
+    val = (val < -3.0) ? -3.0 : val;
+    val = (val > 3.0) ? 3.0 : val;
+
+    const dsp_float val2 = val * val;
+    return val * (27.0 + val2) / (27.0 + 9.0 * val2);
+}
+
 inline dsp_float soft_clip(dsp_float x)
 {
     const dsp_float threshold = 2.5;
@@ -7,11 +7,11 @@ ADSR::ADSR()
 
 void ADSR::initialize()
 {
-    sampleRateMS = DSP::sampleRate / 1000.0;
+    sampleRateMS = getSampleRate() / 1000.0;
     gain = 1.0;
     currentEnv = 0.0;
     oneShot = false;
-    curveBuffer.resize(DSP::blockSize);
+    curveBuffer.resize(getBlockSize());
 
     setAttack(10);
     setDecay(100);
@@ -194,12 +194,16 @@ void ADSR::phaseRelease()
 void ADSR::processBlock(DSPObject *dsp)
 {
     ADSR *adsr = static_cast<ADSR *>(dsp);
-    size_t blocksize = DSP::blockSize;
+    adsr->generate(0, adsr->getBlockSize());
+}
 
-    for (size_t i = 0; i < blocksize; ++i)
+// Generates the samples [start, end) of the current block
+void ADSR::generate(size_t start, size_t end)
+{
+    for (size_t i = start; i < end; ++i)
     {
-        (adsr->*adsr->phaseFunc)();
-        adsr->curveBuffer[i] = adsr->currentEnv * adsr->gain;
+        (this->*phaseFunc)();
+        curveBuffer[i] = currentEnv * gain;
     }
 }
 
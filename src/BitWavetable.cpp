@@ -10,5 +10,5 @@ static dsp_float bitAmplitude(int harmonic)
 void BitWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, bitAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), bitAmplitude, 0.5);
 }
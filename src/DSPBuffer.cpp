@@ -12,17 +12,19 @@ DSPBuffer::DSPBuffer()
     bufferOrig = &buffer;
 }
 
-// Resize the internal buffer and initialize new elements to 0.0
+// Resize the internal buffer and initialize new elements to 0.0,
+// the storage shrinks to the new size (e.g. from maxBlockSize to the block size)
 void DSPBuffer::resize(size_t newSize)
 {
     buffer.resize(clampmin(newSize , static_cast<size_t>(1)), 0.0);
+    buffer.shrink_to_fit();
     bufferOrig = &buffer;
 }
 
 // Set all buffer elements to 0.0
 void DSPBuffer::clear()
 {
-    std::fill(buffer.begin(), buffer.begin() + DSP::blockSize, 0.0);
+    std::fill(buffer.begin(), buffer.end(), 0.0);
 }
 
 // Return a mutable pointer to the internal buffer data
@@ -62,31 +64,32 @@ void DSPBuffer::applyGain(dsp_float gain)
         sample *= gain;
 }
 
-// Copy contents from another DSPBuffer instance
+// Copy contents from another DSPBuffer instance, as many samples as both buffers hold
 void DSPBuffer::set(const DSPBuffer &other)
 {
-    std::copy(other.buffer.begin(), other.buffer.begin() + DSP::blockSize, buffer.begin());
+    size_t count = std::min(buffer.size(), other.buffer.size());
+    std::copy(other.buffer.begin(), other.buffer.begin() + count, buffer.begin());
 }
 
-// Copy raw data from an external float array into the buffer
+// Copy raw data from an external float array into the buffer, the source holds at least size() samples
 void DSPBuffer::set(const float *source)
 {
-    for (size_t i = 0; i < DSP::blockSize; ++i)
+    for (size_t i = 0; i < buffer.size(); ++i)
         buffer[i] = static_cast<dsp_float>(source[i]);
 }
 
 #ifdef USE_DOUBLE_PRECISION
-// Copy raw data from an external dsp_float array into the buffer
+// Copy raw data from an external dsp_float array into the buffer, the source holds at least size() samples
 void DSPBuffer::set(const double *source)
 {
-    std::copy(source, source + DSP::blockSize, buffer.begin());
+    std::copy(source, source + buffer.size(), buffer.begin());
 }
 #endif
 
 // Fill the buffer with a constant value
 void DSPBuffer::fill(dsp_float value)
 {
-    std::fill(buffer.begin(), buffer.begin() + DSP::blockSize, value);
+    std::fill(buffer.begin(), buffer.end(), value);
 }
 
 // Switches the current buffer to a source buffer (shallow reference switch)
@@ -105,6 +108,7 @@ void DSPBuffer::restore()
 DSPBuffer DSPBuffer::clone() const
 {
     DSPBuffer clonedCopy;
-    std::copy(buffer.begin(), buffer.begin() + DSP::blockSize, clonedCopy.buffer.begin());
+    clonedCopy.resize(buffer.size());
+    std::copy(buffer.begin(), buffer.end(), clonedCopy.buffer.begin());
     return clonedCopy;
 }
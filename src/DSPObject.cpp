@@ -18,6 +18,13 @@ void DSPObject::initialize()
 {
 }
 
+// Sets the sample rate and block size the object renders at
+void DSPObject::setAudioSettings(dsp_float rate, size_t size)
+{
+    audioRate = clamp(rate, 1.0, maxSamplerate);
+    audioBlockSize = clamp(size, static_cast<size_t>(1), maxBlockSize);
+}
+
 // Generates the next audio sample block
 void DSPObject::generateBlock()
 {
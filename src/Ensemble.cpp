@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include "Ensemble.h"
+#include "clamp.h"
+
+// The PI
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Taps of both channels
+static constexpr int allTaps = 2 * Ensemble::TapCount;
+
+// Ctor
+Ensemble::Ensemble()
+{
+}
+
+// Allocates the delay line for the current sample rate and clears it
+void Ensemble::initialize()
+{
+    DSPObject::initialize();
+
+    // Room for the longest delay and the interpolation neighbour
+    size_t frames = 1;
+    size_t needed = static_cast<size_t>(maxDelay * 0.001 * getSampleRate()) + 2;
+
+    while (frames < needed)
+        frames <<= 1;
+
+    ring.assign(2 * frames, 0.0);
+    mask = frames - 1;
+    writeFrame = 0;
+
+    currentMix = 0.0;
+    slowPhase = 0.0;
+    fastPhase = 0.0;
+}
+
+// Sets the wet share 0 - 1, 0 bypasses the ensemble
+void Ensemble::setMix(dsp_float value)
+{
+    mix = clamp(value, 0.0, 1.0);
+}
+
+// Sets the rate of the slow LFO in Hz, the vibrato LFO runs ten times faster
+void Ensemble::setRate(dsp_float hz)
+{
+    rate = clamp(hz, 0.0, 10.0);
+}
+
+// Sets the delay modulation of the slow LFO in ms, the vibrato LFO modulates a tenth
+void Ensemble::setDepth(dsp_float ms)
+{
+    depth = clamp(ms, 0.0, 10.0);
+}
+
+// Sets the center delay of the taps in ms
+void Ensemble::setDelay(dsp_float ms)
+{
+    delay = clamp(ms, 1.0, 25.0);
+}
+
+// True if the ensemble is heard or fades out
+bool Ensemble::isActive() const
+{
+    return mix > 0.0 || currentMix > 0.0;
+}
+
+// Delays in samples of all taps at the given LFO phases, left taps first
+void Ensemble::tapDelays(dsp_float slow, dsp_float fast, dsp_float *delays) const
+{
+    dsp_float samplesPerMs = getSampleRate() * 0.001;
+    dsp_float longest = static_cast<dsp_float>(mask - 1);
+
+    for (int t = 0; t < allTaps; ++t)
+    {
+        // Taps 120 degrees apart, the right channel half a cycle off
+        dsp_float offset = static_cast<dsp_float>(t % TapCount) / TapCount + (t < TapCount ? 0.0 : 0.5);
+
+        dsp_float ms = delay + depth * std::sin(2.0 * M_PI * (slow + offset)) +
+                       depth * fastDepth * std::sin(2.0 * M_PI * (fast + offset));
+
+        delays[t] = clamp(ms * samplesPerMs, 1.0, longest);
+    }
+}
+
+// Processes the first samples of left and right in place: the taps read the
+// delay line at linearly interpolated fractional positions, the wet share
+// ramps to the mix set over the block
+void Ensemble::process(DSPBuffer &left, DSPBuffer &right, size_t samples)
+{
+    if (!isActive() || samples == 0 || ring.empty())
+        return;
+
+    // A new start begins with an empty delay line
+    if (currentMix == 0.0)
+        std::fill(ring.begin(), ring.end(), 0.0);
+
+    dsp_float span = static_cast<dsp_float>(samples);
+
+    // Tap delays at both block boundaries, ramped in between
+    alignas(64) dsp_float delayStart[allTaps];
+    alignas(64) dsp_float delayStep[allTaps];
+
+    dsp_float slowEnd = slowPhase + rate * span / getSampleRate();
+    dsp_float fastEnd = fastPhase + rate * fastRatio * span / getSampleRate();
+
+    tapDelays(slowPhase, fastPhase, delayStart);
+    tapDelays(slowEnd, fastEnd, delayStep);
+
+    for (int t = 0; t < allTaps; ++t)
+        delayStep[t] = (delayStep[t] - delayStart[t]) / span;
+
+    slowPhase = slowEnd - std::floor(slowEnd);
+    fastPhase = fastEnd - std::floor(fastEnd);
+
+    dsp_float mixStep = (mix - currentMix) / span;
+    dsp_float wetGain = currentMix;
+    dsp_float tapGain = 1.0 / TapCount;
+    dsp_float frames = static_cast<dsp_float>(mask + 1);
+
+    dsp_float *line = ring.data();
+    dsp_float *outL = left.data();
+    dsp_float *outR = right.data();
+
+    for (size_t i = 0; i < samples; ++i)
+    {
+        size_t frame = writeFrame;
+        line[2 * frame] = outL[i];
+        line[2 * frame + 1] = outR[i];
+        writeFrame = (writeFrame + 1) & mask;
+
+        dsp_float n = static_cast<dsp_float>(i + 1);
+
+        // Read positions of all taps, one frame ahead of the ring wrap
+        alignas(64) dsp_float position[allTaps];
+
+        for (int t = 0; t < allTaps; ++t)
+            position[t] = static_cast<dsp_float>(frame) + frames - (delayStart[t] + delayStep[t] * n);
+
+        dsp_float wet[2] = {0.0, 0.0};
+
+        for (int t = 0; t < allTaps; ++t)
+        {
+            size_t index = static_cast<size_t>(position[t]);
+            dsp_float frac = position[t] - static_cast<dsp_float>(index);
+            int channel = t < TapCount ? 0 : 1;
+
+            dsp_float a = line[2 * (index & mask) + channel];
+            dsp_float b = line[2 * ((index + 1) & mask) + channel];
+
+            wet[channel] += a + (b - a) * frac;
+        }
+
+        wetGain += mixStep;
+
+        outL[i] += (wet[0] * tapGain - outL[i]) * wetGain;
+        outR[i] += (wet[1] * tapGain - outR[i]) * wetGain;
+    }
+
+    currentMix = mix;
+}
@@ -27,5 +27,5 @@ static dsp_float fibonacciAmplitude(int harmonic)
 void FibonacciWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, fibonacciAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), fibonacciAmplitude, 0.5);
 }
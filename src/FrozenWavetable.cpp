@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include "FrozenWavetable.h"
+#include "clamp.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Highest fundamental of the first table in Hz, every table covers the next octave
+static constexpr dsp_float firstOctave = 40.0;
+
+// Ctor
+FrozenWavetable::FrozenWavetable()
+{
+}
+
+// Allocates the tables for the current sample rate and drops a frozen cycle
+void FrozenWavetable::initialize()
+{
+    DSPObject::initialize();
+
+    cycle.assign(tableSize, 0.0);
+    sum.assign(tableSize, 0.0);
+    tables.assign(tableSize * levelCount, 0.0);
+    sine.resize(tableSize);
+
+    for (size_t k = 0; k < tableSize; ++k)
+        sine[k] = std::sin(2.0 * M_PI * static_cast<dsp_float>(k) / tableSize);
+
+    // Harmonics below Nyquist at the highest fundamental of each octave
+    dsp_float top = firstOctave;
+
+    for (int l = 0; l < levelCount; ++l, top *= 2.0)
+        harmonicLimit[l] = clamp(static_cast<int>(0.5 * getSampleRate() / top), 1, static_cast<int>(tableSize / 2 - 1));
+
+    reset();
+}
+
+// Sets up the harmonic sum after the cycle was sampled
+void FrozenWavetable::start()
+{
+    dsp_float total = 0.0;
+
+    for (size_t k = 0; k < tableSize; ++k)
+        total += cycle[k];
+
+    dc = total / tableSize;
+    std::fill(sum.begin(), sum.end(), dc);
+
+    harmonic = 1;
+    ready = false;
+}
+
+// Analyses and adds the next count harmonics, true once all tables are complete
+bool FrozenWavetable::build(int count)
+{
+    const size_t mask = tableSize - 1;
+    const size_t quarter = tableSize / 4;
+    const dsp_float scale = 2.0 / tableSize;
+
+    for (; count > 0 && harmonic > 0; --count)
+    {
+        size_t n = static_cast<size_t>(harmonic);
+
+        // Sine and cosine amplitude of harmonic n
+        dsp_float a = 0.0;
+        dsp_float b = 0.0;
+
+        for (size_t k = 0; k < tableSize; ++k)
+        {
+            size_t i = (n * k) & mask;
+            a += cycle[k] * sine[(i + quarter) & mask];
+            b += cycle[k] * sine[i];
+        }
+
+        a *= scale;
+        b *= scale;
+
+        for (size_t k = 0; k < tableSize; ++k)
+        {
+            size_t i = (n * k) & mask;
+            sum[k] += a * sine[(i + quarter) & mask] + b * sine[i];
+        }
+
+        // Every table is a snapshot of the sum at its highest harmonic
+        for (int l = 0; l < levelCount; ++l)
+        {
+            if (harmonicLimit[l] == harmonic)
+                std::copy(sum.begin(), sum.end(), tables.begin() + l * tableSize);
+        }
+
+        if (harmonic == harmonicLimit[0])
+        {
+            harmonic = 0;
+            ready = true;
+        }
+        else
+        {
+            ++harmonic;
+        }
+    }
+
+    return ready;
+}
+
+// Drops the frozen cycle
+void FrozenWavetable::reset()
+{
+    harmonic = 0;
+    ready = false;
+}
+
+// True while harmonics are still added
+bool FrozenWavetable::isBuilding() const
+{
+    return harmonic > 0;
+}
+
+// True if the tables are complete
+bool FrozenWavetable::isReady() const
+{
+    return ready;
+}
+
+// Renders the samples [start, end) into out, the table is picked by the fundamental
+void FrozenWavetable::render(dsp_float *out, dsp_float phase, dsp_float increment, size_t start, size_t end) const
+{
+    dsp_float frequency = increment * getSampleRate();
+    int level = 0;
+    dsp_float top = firstOctave;
+
+    while (level < levelCount - 1 && frequency > top)
+    {
+        ++level;
+        top *= 2.0;
+    }
+
+    const dsp_float *table = tables.data() + level * tableSize;
+    const size_t mask = tableSize - 1;
+
+    for (size_t i = start; i < end; ++i)
+    {
+        phase += increment;
+
+        if (phase >= 1.0)
+            phase -= 1.0;
+
+        dsp_float index = phase * tableSize;
+        size_t i0 = static_cast<size_t>(index);
+        dsp_float frac = index - i0;
+
+        out[i] = (1.0 - frac) * table[i0 & mask] + frac * table[(i0 + 1) & mask];
+    }
+}
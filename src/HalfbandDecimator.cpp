@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "HalfbandDecimator.h"
+
+// Ctor
+HalfbandDecimator::HalfbandDecimator()
+{
+    HalfbandUpsampler::calcCoefficients(coefficients);
+}
+
+// Allocates the state for channels of up to samples output samples per block
+void HalfbandDecimator::initialize(int channels, size_t samples)
+{
+    history.resize(std::max(channels, 1));
+
+    for (auto &channel : history)
+        channel.assign(2 * (branchTaps - 1), 0.0);
+
+    work.assign(2 * (branchTaps - 1) + 2 * samples, 0.0);
+    output.assign(samples, 0.0);
+}
+
+// Clears the filter history
+void HalfbandDecimator::reset()
+{
+    for (auto &channel : history)
+        std::fill(channel.begin(), channel.end(), 0.0);
+}
+
+// Clears the filter history of one channel
+void HalfbandDecimator::reset(int channel)
+{
+    std::fill(history[channel].begin(), history[channel].end(), 0.0);
+}
+
+// Continues a channel from the filter history of another channel
+void HalfbandDecimator::copy(int channel, int source)
+{
+    history[channel] = history[source];
+}
+
+// Decimates 2 * samples input samples of one channel, returns samples output samples
+const dsp_float *HalfbandDecimator::process(int channel, const dsp_float *input, size_t samples)
+{
+    const size_t delay = 2 * (branchTaps - 1);
+
+    samples = std::min(samples, output.size());
+
+    std::vector<dsp_float> &state = history[channel];
+    dsp_float *x = work.data();
+    dsp_float *y = output.data();
+
+    std::copy(state.data(), state.data() + delay, x);
+    std::copy(input, input + 2 * samples, x + delay);
+
+    for (size_t p = 0; p < samples; ++p)
+    {
+        // Output p is aligned with input 2p, the branch reaches back to x[-62] in steps of two
+        const dsp_float *newest = x + delay + 2 * p;
+        dsp_float sum = 0.0;
+
+        for (int s = 0; s < branchTaps / 2; ++s)
+            sum += coefficients[s] * (newest[-2 * s] + newest[2 * s - static_cast<int>(delay)]);
+
+        // The half-band center tap is 0.5, the branch carries the other half
+        y[p] = 0.5 * (sum + newest[-static_cast<int>(delay / 2)]);
+    }
+
+    std::copy(x + 2 * samples, x + 2 * samples + delay, state.data());
+
+    return y;
+}
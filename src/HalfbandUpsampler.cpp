@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cmath>
+#include "HalfbandUpsampler.h"
+
+// Kaiser window shape, about 70 dB stopband attenuation
+static constexpr dsp_float kaiserBeta = 7.8;
+
+// Zeroth order modified Bessel function of the first kind (power series)
+static dsp_float besselI0(dsp_float x)
+{
+    dsp_float sum = 1.0;
+    dsp_float term = 1.0;
+    dsp_float quarter = 0.25 * x * x;
+
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= quarter / (static_cast<dsp_float>(k) * k);
+        sum += term;
+
+        if (term < sum * 1e-17)
+            break;
+    }
+
+    return sum;
+}
+
+// Ctor
+HalfbandUpsampler::HalfbandUpsampler()
+{
+    calcCoefficients(coefficients);
+}
+
+// Computes the branch coefficients: the odd taps of the half-band prototype
+// h[n] = sin(pi n / 2) / (pi n) * w[n], n = -31..31, scaled to unity DC gain
+void HalfbandUpsampler::calcCoefficients(dsp_float *coefficients)
+{
+    const int half = branchTaps - 1;
+    dsp_float sum = 0.0;
+
+    for (int s = 0; s < branchTaps; ++s)
+    {
+        int n = 2 * s - half;
+        dsp_float ratio = static_cast<dsp_float>(n) / half;
+        dsp_float window = besselI0(kaiserBeta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / besselI0(kaiserBeta);
+
+        coefficients[s] = std::sin(M_PI * n * 0.5) / (M_PI * n) * window;
+        sum += coefficients[s];
+    }
+
+    for (int s = 0; s < branchTaps; ++s)
+        coefficients[s] /= sum;
+}
+
+// Allocates the state for channels of up to samples input samples per block
+void HalfbandUpsampler::initialize(int channels, size_t samples)
+{
+    history.resize(std::max(channels, 1));
+
+    for (auto &channel : history)
+        channel.assign(branchTaps - 1, 0.0);
+
+    work.assign(branchTaps - 1 + samples, 0.0);
+    output.assign(2 * samples, 0.0);
+}
+
+// Clears the filter history
+void HalfbandUpsampler::reset()
+{
+    for (auto &channel : history)
+        std::fill(channel.begin(), channel.end(), 0.0);
+}
+
+// Clears the filter history of one channel
+void HalfbandUpsampler::reset(int channel)
+{
+    std::fill(history[channel].begin(), history[channel].end(), 0.0);
+}
+
+// Continues a channel from the filter history of another channel
+void HalfbandUpsampler::copy(int channel, int source)
+{
+    history[channel] = history[source];
+}
+
+// Upsamples a block of one channel, returns 2 * samples output samples
+const dsp_float *HalfbandUpsampler::process(int channel, const dsp_float *input, size_t samples)
+{
+    const size_t delay = branchTaps - 1;
+
+    samples = std::min(samples, output.size() / 2);
+
+    std::vector<dsp_float> &state = history[channel];
+    dsp_float *x = work.data();
+    dsp_float *y = output.data();
+
+    std::copy(state.data(), state.data() + delay, x);
+    std::copy(input, input + samples, x + delay);
+
+    for (size_t p = 0; p < samples; ++p)
+    {
+        // x[0] is the newest input, x[-31] the oldest the branch reaches
+        const dsp_float *newest = x + delay + p;
+        dsp_float sum = 0.0;
+
+        for (int s = 0; s < branchTaps / 2; ++s)
+            sum += coefficients[s] * (newest[-s] + newest[s - static_cast<int>(delay)]);
+
+        y[2 * p] = sum;
+        y[2 * p + 1] = newest[-static_cast<int>(delay / 2)];
+    }
+
+    std::copy(x + samples, x + samples + delay, state.data());
+
+    return y;
+}
@@ -11,5 +11,5 @@ static dsp_float clusterAmplitude(int harmonic)
 void HarmonicClusterWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, clusterAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), clusterAmplitude, 0.5);
 }
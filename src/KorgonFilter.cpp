@@ -17,8 +17,8 @@ void KorgonFilter::initialize()
 {
     DSPObject::initialize();
 
-    cutoffInitBuffer.resize(DSP::blockSize);
-    resoInitBuffer.resize(DSP::blockSize);
+    cutoffInitBuffer.resize(getBlockSize());
+    resoInitBuffer.resize(getBlockSize());
 
     cutoffInitBuffer.fill(20000.0);
     resoInitBuffer.fill(0.0);
@@ -28,14 +28,28 @@ void KorgonFilter::initialize()
     setDrive(0.0);
     reset();
 
-    T = 1.0 / DSP::sampleRate;
+    T = 1.0 / (getSampleRate() * (1 << controlShift));
     drive = 1.0;
 }
 
-// Set the cutoff frequency and update coefficients
+// Enables the soft clipping output stage, off runs the filter linear
+void KorgonFilter::setSaturation(bool enabled)
+{
+    saturated = enabled;
+}
+
+// Runs the filter on samples at 1, 2 or 4 times the sample rate, the cutoff and
+// resonance inputs stay at the sample rate
+void KorgonFilter::setOversampling(int factor)
+{
+    controlShift = factor >= 4 ? 2 : (factor >= 2 ? 1 : 0);
+    T = 1.0 / (getSampleRate() * (1 << controlShift));
+}
+
+// Set the cutoff frequency and update coefficients, nullptr for the fully open default
 void KorgonFilter::setCutoff(DSPBuffer *buffer)
 {
-    cutoffBuffer = buffer;
+    cutoffBuffer = buffer ? buffer : &cutoffInitBuffer;
 }
 
 // Set the resonance amount
@@ -57,12 +71,40 @@ void KorgonFilter::setDrive(dsp_float value)
     drive = clamp(value, 0.0, 1.0) * 1.0 + 1.0;
 }
 
-// Process a single sample through the MS-20 style lowpass filter
+// Processes the whole block
 void KorgonFilter::processBlock(DSPObject *dsp)
 {
     KorgonFilter *flt = static_cast<KorgonFilter *>(dsp);
+    flt->process(0, flt->getBlockSize());
+}
+
+// Filters the samples [start, end) of the sample buffers in place
+void KorgonFilter::process(size_t start, size_t end)
+{
+    if (saturated)
+        processKernel<false, true>(start, end);
+    else
+        processKernel<false, false>(start, end);
+}
+
+// Filters the samples [start, end) of the left buffer only, the right state follows the left
+void KorgonFilter::processMono(size_t start, size_t end)
+{
+    if (saturated)
+        processKernel<true, true>(start, end);
+    else
+        processKernel<true, false>(start, end);
+
+    y1R = y1L;
+    y2R = y2L;
+}
+
+// Process the samples [start, end) through the MS-20 style lowpass filter
+template <bool Mono, bool Saturated>
+void KorgonFilter::processKernel(size_t start, size_t end)
+{
+    KorgonFilter *flt = this;
 
-    size_t blocksize = DSP::blockSize;
     dsp_float left, right;
     dsp_float cutoff, reso;
     dsp_float wc, alpha;
@@ -75,20 +117,18 @@ void KorgonFilter::processBlock(DSPObject *dsp)
     dsp_float T = flt->T;
     dsp_float drive = flt->drive;
     dsp_float reso_scale;
+    int shift = flt->controlShift;
 
-    for (size_t i = 0; i < blocksize; ++i)
+    for (size_t i = start; i < end; ++i)
     {
-        left = (*flt->bufferL)[i];
-        right = (*flt->bufferR)[i];
-        cutoff = clamp((*flt->cutoffBuffer)[i], 0.0, 20000.0);
-        reso = (*flt->resoBuffer)[i];
+        cutoff = clamp((*flt->cutoffBuffer)[i >> shift], 0.0, 20000.0);
 
+        // Fully open: the samples pass unchanged
         if (cutoff > 15000.0)
-        {
-            (*flt->bufferL)[i] = left;
-            (*flt->bufferR)[i] = right;
             continue;
-        }
+
+        left = (*flt->bufferL)[i];
+        reso = (*flt->resoBuffer)[i >> shift];
 
         reso_scale = (cutoff <= 2500.0) ? 1.0 : clamp(1.0 - (cutoff - 2500.0) / 7500.0, 0.0, 1.0);
 
@@ -110,10 +150,17 @@ void KorgonFilter::processBlock(DSPObject *dsp)
 
         // Apply asymmetric soft clip
         left = y2L * drive;
-        left = (left >= 0.0) ? fast_tanh(left) : 1.5 * fast_tanh(0.5 * left);
+
+        if (Saturated)
+            left = (left >= 0.0) ? fast_tanh(left) : 1.5 * fast_tanh(0.5 * left);
+
         (*flt->bufferL)[i] = left;
 
+        if (Mono)
+            continue;
+
         // === right ===
+        right = (*flt->bufferR)[i];
         feedback = clamp(reso * reso_scale * (y2R - right), -15.0, 15.0);
 
         // First integrator (emulating Sallen-Key stage)
@@ -125,7 +172,10 @@ void KorgonFilter::processBlock(DSPObject *dsp)
 
         // Apply asymmetric soft clip
         right = y2R * drive;
-        right = (right >= 0.0) ? fast_tanh(right) : 1.5 * fast_tanh(0.5 * right);
+
+        if (Saturated)
+            right = (right >= 0.0) ? fast_tanh(right) : 1.5 * fast_tanh(0.5 * right);
+
         (*flt->bufferR)[i] = right;
     }
 
@@ -142,4 +192,18 @@ void KorgonFilter::reset()
     y2L = 0.0;
     y1R = 0.0;
     y2R = 0.0;
-}
\ No newline at end of file
+}
+
+// True if the cutoff is fully open for the samples [start, end), the filter passes the signal
+bool KorgonFilter::isOpen(size_t start, size_t end) const
+{
+    const DSPBuffer &cutoff = *cutoffBuffer;
+
+    for (size_t i = start; i < end; ++i)
+    {
+        if (!(cutoff[i] > 15000.0))
+            return false;
+    }
+
+    return true;
+}
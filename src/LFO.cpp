@@ -7,11 +7,12 @@ LFO::LFO()
 
 void LFO::initialize()
 {
-    samplerate = DSP::sampleRate;
-    lfoBuffer.resize(DSP::blockSize);
+    samplerate = getSampleRate();
+    lfoBuffer.resize(getBlockSize());
 
     phase = 0.0;
     phaseInc = 0.0;
+    smoothVal = 0.0;
     
     setFreq(0.0);
     setOffset(0.0);
@@ -150,7 +151,7 @@ void LFO::setModBuffer(float* buffer)
 void LFO::processBlock(DSPObject *dsp)
 {
     LFO *lfo = static_cast<LFO *>(dsp);
-    size_t n = DSP::blockSize;
+    size_t n = lfo->getBlockSize();
 
     if (lfo->freq <= 0.0)
     {
@@ -186,6 +187,34 @@ void LFO::processBlock(DSPObject *dsp)
     lfo->phase = phase;
 }
 
+// Evaluates the LFO once and advances it by samples, for control rate modulation
+dsp_float LFO::tick(size_t samples)
+{
+    if (freq <= 0.0)
+    {
+        phase = 0.0;
+        return idleSignal;
+    }
+
+    double target = (this->*lfoFunc)() * depth + offset;
+
+    // The per sample smoothing compounded over the step
+    double coeff = 1.0 - std::pow(1.0 - smoothCoeff, static_cast<double>(samples));
+    smoothVal += coeff * (target - smoothVal);
+
+    phase += phaseInc * static_cast<double>(samples);
+
+    if (phase >= 1.0)
+    {
+        phase -= std::floor(phase);
+
+        if (onPhaseWrap)
+            onPhaseWrap();
+    }
+
+    return smoothVal;
+}
+
 dsp_float *LFO::getBuffer()
 {
     return lfoBuffer.data();
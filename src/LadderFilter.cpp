@@ -59,7 +59,7 @@ void LadderFilter::processBlock(DSPObject *dsp)
     dsp_float s1R = flt->s1R, s2R = flt->s2R, s3R = flt->s3R, s4R = flt->s4R;
 
     // Compute g from the cutoff frequency (normalized angular frequency)
-    dsp_float g = tan(M_PI * flt->cutoff / DSP::sampleRate);
+    dsp_float g = tan(M_PI * flt->cutoff / flt->getSampleRate());
 
     // Compute the smoothing coefficient (1-pole lowpass response)
     dsp_float alpha = g / (1.0 + g);
@@ -71,7 +71,7 @@ void LadderFilter::processBlock(DSPObject *dsp)
     else
         compensation = 1.0 / std::pow(1.0 + g, 1.0);
 
-    size_t blocksize = DSP::blockSize;
+    size_t blocksize = flt->getBlockSize();
     dsp_float left;
     dsp_float right;
 
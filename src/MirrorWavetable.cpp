@@ -10,5 +10,5 @@ static dsp_float mirrorAmplitude(int harmonic)
 void MirrorWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, mirrorAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), mirrorAmplitude, 0.5);
 }
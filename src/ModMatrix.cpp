@@ -0,0 +1,61 @@
+#include "ModMatrix.h"
+
+// Sets the amount a source modulates a destination, 0 removes the route
+void ModMatrix::setAmount(ModSource source, ModDestination destination, dsp_float amount)
+{
+    dsp_float &route = amounts[static_cast<int>(source)][static_cast<int>(destination)];
+
+    if (route != 0.0)
+        --routes;
+
+    route = amount;
+
+    if (route != 0.0)
+        ++routes;
+}
+
+// True if any route is set
+bool ModMatrix::isActive() const
+{
+    return routes > 0;
+}
+
+// True if the destination receives at least one source
+bool ModMatrix::isRouted(ModDestination destination) const
+{
+    for (int s = 0; s < ModSourceCount; ++s)
+    {
+        if (amounts[s][static_cast<int>(destination)] != 0.0)
+            return true;
+    }
+
+    return false;
+}
+
+// True if the source feeds at least one destination
+bool ModMatrix::uses(ModSource source) const
+{
+    for (int d = 0; d < ModDestinationCount; ++d)
+    {
+        if (amounts[static_cast<int>(source)][d] != 0.0)
+            return true;
+    }
+
+    return false;
+}
+
+// Sums the scaled source values per destination
+void ModMatrix::evaluate(const dsp_float *sources, dsp_float *destinations) const
+{
+    for (int d = 0; d < ModDestinationCount; ++d)
+        destinations[d] = 0.0;
+
+    for (int s = 0; s < ModSourceCount; ++s)
+    {
+        if (sources[s] == 0.0)
+            continue;
+
+        for (int d = 0; d < ModDestinationCount; ++d)
+            destinations[d] += sources[s] * amounts[s][d];
+    }
+}
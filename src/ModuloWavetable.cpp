@@ -12,5 +12,5 @@ static dsp_float moduloAmplitude(int harmonic)
 void ModuloWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, moduloAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), moduloAmplitude, 0.5);
 }
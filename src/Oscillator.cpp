@@ -43,10 +43,10 @@ void Oscillator::initialize()
 {
     DSPObject::initialize();
 
-    outBufferL.resize(DSP::blockSize);
-    outBufferR.resize(DSP::blockSize);
-    modBufferL.resize(DSP::blockSize);
-    modBufferR.resize(DSP::blockSize);
+    outBufferL.resize(getBlockSize());
+    outBufferR.resize(getBlockSize());
+    modBufferL.resize(getBlockSize());
+    modBufferR.resize(getBlockSize());
 
     setFrequency(0.0);
     setFineTune(0);
@@ -113,7 +113,7 @@ void Oscillator::setCalculatedFrequency(dsp_float f)
     calculatedFrequency = f * std::pow(2.0, semitoneOffset / 12.0);
 
     // Update phase increment for waveform generation
-    phaseIncrement = calculatedFrequency / DSP::sampleRate;
+    phaseIncrement = calculatedFrequency / getSampleRate();
 }
 
 // Gets the current frequency
@@ -208,11 +208,11 @@ void Oscillator::processBlock(DSPObject *dsp)
     dsp_float baseFreq = osc->calculatedFrequency;
     dsp_float index = osc->modulationIndex;
     FMType fmType = osc->fmType;
-    dsp_float sr = DSP::sampleRate;
+    dsp_float sr = osc->getSampleRate();
     dsp_float phaseIncrement = osc->phaseIncrement;
     dsp_float left, right;
     bool negativeWrappingEnabled = osc->negativeWrappingEnabled;
-    size_t blocksize = DSP::blockSize;
+    size_t blocksize = osc->getBlockSize();
 
     if (index > 0.0 && fmType != FMType::None)
     {
@@ -0,0 +1,85 @@
+#include "Oversampler.h"
+
+// Ctor
+Oversampler::Oversampler()
+{
+}
+
+// Allocates the state for factor 1, 2 or 4 and channels of up to samples
+// samples per block at the low rate
+void Oversampler::initialize(int factor, int channels, size_t samples)
+{
+    this->factor = factor >= maxFactor ? maxFactor : (factor >= 2 ? 2 : 1);
+
+    size_t stages = this->factor == maxFactor ? 2 : (this->factor == 2 ? 1 : 0);
+
+    upStages.resize(stages);
+    downStages.resize(stages);
+
+    // Stage i runs between the rates 2^i and 2^(i+1)
+    for (size_t i = 0; i < stages; ++i)
+    {
+        upStages[i].initialize(channels, samples << i);
+        downStages[i].initialize(channels, samples << i);
+    }
+
+    reset();
+}
+
+// Gets the oversampling factor
+int Oversampler::getFactor() const
+{
+    return factor;
+}
+
+// Clears the filter history
+void Oversampler::reset()
+{
+    for (auto &stage : upStages)
+        stage.reset();
+
+    for (auto &stage : downStages)
+        stage.reset();
+}
+
+// Clears the filter history of one channel, for a channel that resumes after it was skipped
+void Oversampler::reset(int channel)
+{
+    for (auto &stage : upStages)
+        stage.reset(channel);
+
+    for (auto &stage : downStages)
+        stage.reset(channel);
+}
+
+// Continues a channel from the filter history of another channel, for a channel that
+// resumes after it followed the other one
+void Oversampler::copy(int channel, int source)
+{
+    for (auto &stage : upStages)
+        stage.copy(channel, source);
+
+    for (auto &stage : downStages)
+        stage.copy(channel, source);
+}
+
+// Upsamples a block of one channel, returns factor * samples samples
+const dsp_float *Oversampler::upsample(int channel, const dsp_float *input, size_t samples)
+{
+    for (auto &stage : upStages)
+    {
+        input = stage.process(channel, input, samples);
+        samples *= 2;
+    }
+
+    return input;
+}
+
+// Downsamples factor * samples samples of one channel, returns samples samples
+const dsp_float *Oversampler::downsample(int channel, const dsp_float *input, size_t samples)
+{
+    for (size_t i = downStages.size(); i-- > 0;)
+        input = downStages[i].process(channel, input, samples << i);
+
+    return input;
+}
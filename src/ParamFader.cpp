@@ -1,5 +1,4 @@
 #include "ParamFader.h"
-#include "DSP.h"
 
 // Queue a parameter change
 void ParamFader::change(ParamChange fn)
@@ -39,7 +38,7 @@ void ParamFader::processChanges(DSPBuffer &left, DSPBuffer &right)
         }
 
         // Apply fade to entire output buffer
-        for (size_t i = 0; i < DSP::blockSize; ++i)
+        for (size_t i = 0; i < left.size(); ++i)
         {
             left[i] *= fadeValue;
             right[i] *= fadeValue;
@@ -47,6 +46,20 @@ void ParamFader::processChanges(DSPBuffer &left, DSPBuffer &right)
     }
 }
 
+// Apply all queued changes at once without fading
+void ParamFader::flush()
+{
+    while (!changes.empty())
+    {
+        changes.front()();
+        changes.pop();
+    }
+
+    applyParamChange = false;
+    fadeValue = 1.0;
+    fadeCounter = 0;
+}
+
 /*
 if (applyOscillators)
 {
@@ -0,0 +1,46 @@
+#include "ParameterBlock.h"
+
+// Ctor: default parameters
+ParameterBlock::ParameterBlock()
+{
+}
+
+// Writer: replaces the parameters
+void ParameterBlock::write(const VoiceParameters &values)
+{
+    unsigned long current = sequence.load(std::memory_order_relaxed);
+
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    parameters = values;
+
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+// Reader: copies the parameters if they changed since version and updates version,
+// false if nothing changed
+bool ParameterBlock::read(VoiceParameters &values, unsigned long &version) const
+{
+    while (true)
+    {
+        unsigned long before = sequence.load(std::memory_order_acquire);
+
+        if (before == version)
+            return false;
+
+        // A write is in progress
+        if (before & 1)
+            continue;
+
+        VoiceParameters copy = parameters;
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (sequence.load(std::memory_order_relaxed) == before)
+        {
+            values = copy;
+            version = before;
+            return true;
+        }
+    }
+}
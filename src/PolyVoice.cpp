@@ -0,0 +1,852 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "PolyVoice.h"
+#include "clamp.h"
+#include "dsp_types.h"
+
+// Ctor: creates the voices
+PolyVoice::PolyVoice(int count)
+{
+    slots.resize(clamp(count, 1, 32));
+
+    for (auto &slot : slots)
+    {
+        slot.engine = this;
+        slot.voice = new Voice();
+        slotArgs.push_back(&slot);
+    }
+
+    presets.resize(presetCount);
+
+    laneGroups.resize((slots.size() + LaneCount - 1) / LaneCount);
+
+    for (auto &group : laneGroups)
+    {
+        group.engine = this;
+        groupArgs.push_back(&group);
+    }
+}
+
+// Dtor: deletes all voices
+PolyVoice::~PolyVoice()
+{
+    pool.stop();
+
+    for (auto &slot : slots)
+        delete slot.voice;
+}
+
+// Initializes the voices
+void PolyVoice::initialize()
+{
+    DSPObject::initialize();
+
+    mixBufferL.resize(getBlockSize() * getOutputChannels());
+    mixBufferR.resize(getBlockSize() * getOutputChannels());
+
+    cutoffInitBuffer.resize(getBlockSize());
+    cutoffInitBuffer.fill(envelopesEnabled ? 0.0 : 20000.0);
+    cutoffBuffer = &cutoffInitBuffer;
+
+    // The voices and the ensemble render at the engine's rate, which may differ from the host's
+    for (auto &slot : slots)
+    {
+        slot.voice->setAudioSettings(getSampleRate(), getBlockSize());
+        slot.voice->initialize();
+        slot.voice->setFilterCutoff(cutoffBuffer);
+        slot.note = -1;
+        slot.held = false;
+
+        // Unused voices sleep until a note arrives
+        if (envelopesEnabled)
+            slot.voice->sleep();
+    }
+
+    for (auto &group : laneGroups)
+        group.lanes.initialize(getSampleRate(), getBlockSize());
+
+    ensemble.setAudioSettings(getSampleRate(), getBlockSize());
+    ensemble.initialize();
+    morphing = false;
+    stackSize = 0;
+
+    // The voices start on their defaults, the shared block applies again
+    blockParameters = VoiceParameters();
+    blockVersion = 0;
+}
+
+// Enables note allocation and the voices' envelopes
+void PolyVoice::setEnvelopesEnabled(bool enabled)
+{
+    envelopesEnabled = enabled;
+
+    for (auto &slot : slots)
+        slot.voice->setEnvelopesEnabled(enabled);
+}
+
+// Gets the number of voices
+int PolyVoice::getVoiceCount() const
+{
+    return static_cast<int>(slots.size());
+}
+
+// Converts a MIDI note to Hertz
+dsp_float PolyVoice::mtof(dsp_float note)
+{
+    return 440.0 * std::pow(2.0, (note - 69.0) / 12.0);
+}
+
+// Finds the slot for a new note: same note, free, released or oldest
+PolySlot *PolyVoice::allocate(int note)
+{
+    PolySlot *freeSlot = nullptr;
+    PolySlot *released = nullptr;
+    PolySlot *oldest = nullptr;
+
+    for (auto &slot : slots)
+    {
+        // Retrigger a note that is still sounding
+        if (slot.note == note)
+            return &slot;
+
+        if (slot.note < 0 || slot.voice->isIdle())
+        {
+            if (!freeSlot)
+                freeSlot = &slot;
+        }
+        else if (!slot.held)
+        {
+            if (!released || slot.age < released->age)
+                released = &slot;
+        }
+        else if (!oldest || slot.age < oldest->age)
+        {
+            oldest = &slot;
+        }
+    }
+
+    if (freeSlot)
+        return freeSlot;
+
+    if (released)
+        return released;
+
+    return oldest;
+}
+
+// Plays a MIDI note at a sample offset within the next block, velocity 0 releases the note
+void PolyVoice::noteOn(int note, dsp_float velocity, size_t offset)
+{
+    if (!envelopesEnabled)
+        return;
+
+    if (velocity <= 0.0)
+    {
+        noteOff(note, offset);
+        return;
+    }
+
+    if (paraphonic)
+    {
+        paraphonicNoteOn(note, velocity, offset);
+        return;
+    }
+
+    PolySlot *slot = allocate(note);
+
+    slot->note = note;
+    slot->held = true;
+    slot->age = ++noteCounter;
+
+    slot->voice->schedule(VoiceEventType::Frequency, mtof(note), offset);
+    slot->voice->schedule(VoiceEventType::Velocity, velocity, offset);
+    slot->voice->schedule(VoiceEventType::Gate, 1.0, offset);
+}
+
+// Releases a MIDI note at a sample offset within the next block
+void PolyVoice::noteOff(int note, size_t offset)
+{
+    if (paraphonic)
+    {
+        paraphonicNoteOff(note, offset);
+        return;
+    }
+
+    for (auto &slot : slots)
+    {
+        if (slot.note == note && slot.held)
+        {
+            slot.held = false;
+            slot.voice->schedule(VoiceEventType::Gate, 0.0, offset);
+        }
+    }
+}
+
+// Adds a note to the paraphonic stack, the oldest note gives way when it is full
+void PolyVoice::paraphonicNoteOn(int note, dsp_float velocity, size_t offset)
+{
+    PolySlot &slot = slots.front();
+    bool retrigger = (stackSize == 0);
+    int *end = noteStack + stackSize;
+
+    if (std::find(noteStack, end, note) == end)
+    {
+        if (stackSize == WavetableOscillator::maxVoices)
+        {
+            std::copy(noteStack + 1, end, noteStack);
+            --stackSize;
+        }
+
+        noteStack[stackSize++] = note;
+    }
+
+    slot.held = true;
+    slot.age = ++noteCounter;
+
+    // A chord change while notes are held applies at once, legato
+    updateParaphony(retrigger ? offset : 0);
+
+    if (retrigger)
+    {
+        slot.voice->schedule(VoiceEventType::Velocity, velocity, offset);
+        slot.voice->schedule(VoiceEventType::Gate, 1.0, offset);
+    }
+}
+
+// Removes a note from the paraphonic stack, the last one closes the gate
+void PolyVoice::paraphonicNoteOff(int note, size_t offset)
+{
+    PolySlot &slot = slots.front();
+    int *end = noteStack + stackSize;
+    int *found = std::find(noteStack, end, note);
+
+    if (found == end)
+        return;
+
+    std::copy(found + 1, end, found);
+    --stackSize;
+
+    // The released chord keeps sounding in the release phase
+    if (stackSize == 0)
+    {
+        slot.held = false;
+        slot.voice->schedule(VoiceEventType::Gate, 0.0, offset);
+        return;
+    }
+
+    updateParaphony(0);
+}
+
+// Plays the held notes through the first voice
+void PolyVoice::updateParaphony(size_t offset)
+{
+    PolySlot &slot = slots.front();
+    int root = *std::min_element(noteStack, noteStack + stackSize);
+    dsp_float semitones[WavetableOscillator::maxVoices];
+
+    for (int i = 0; i < stackSize; ++i)
+        semitones[i] = noteStack[i] - root;
+
+    slot.note = root;
+    // The chord changes together with the root
+    slot.voice->schedule(VoiceEventType::Frequency, mtof(root), offset);
+    slot.voice->scheduleChord(semitones, stackSize, offset);
+}
+
+// Plays a chord through every voice, pitches in semi tones relative to the note
+void PolyVoice::setChord(const dsp_float *semitones, int count)
+{
+    for (auto &slot : slots)
+        slot.voice->setChord(semitones, count);
+}
+
+// Paraphonic mode: the held notes play as a chord through the first voice
+void PolyVoice::setParaphonic(bool enabled)
+{
+    if (enabled == paraphonic)
+        return;
+
+    paraphonic = enabled;
+    stackSize = 0;
+
+    // Notes held in the other mode are released
+    for (auto &slot : slots)
+    {
+        if (slot.held)
+        {
+            slot.held = false;
+            slot.voice->schedule(VoiceEventType::Gate, 0.0, 0);
+        }
+    }
+
+    slots.front().voice->setChord(nullptr, 0);
+}
+
+// Sets the pitch bend in semi tones, the voices smooth it over the bend time
+void PolyVoice::setPitchBend(dsp_float semitones, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::PitchBend, semitones, offset);
+}
+
+// Sets the portamento time in ms and its curve, 0 jumps to a new note
+void PolyVoice::setGlide(dsp_float ms, SlewMode mode)
+{
+    for (auto &slot : slots)
+        slot.voice->setGlide(ms, mode);
+}
+
+// Sets the time in ms a pitch bend change is smoothed over
+void PolyVoice::setBendTime(dsp_float ms)
+{
+    for (auto &slot : slots)
+        slot.voice->setBendTime(ms);
+}
+
+// Sets the output gain of the summed voices
+void PolyVoice::setGain(dsp_float g)
+{
+    gain = clampmin(g, 0.0);
+}
+
+// Sets a parameter of all amplitude envelopes
+void PolyVoice::setAmpEnvelope(EnvelopeParam param, dsp_float value)
+{
+    for (auto &slot : slots)
+        slot.voice->setAmpEnvelope(param, value);
+}
+
+// Sets a parameter of all filter envelopes
+void PolyVoice::setFilterEnvelope(EnvelopeParam param, dsp_float value)
+{
+    for (auto &slot : slots)
+        slot.voice->setFilterEnvelope(param, value);
+}
+
+void PolyVoice::setModIndex(dsp_float index, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::ModIndex, index, offset);
+}
+
+void PolyVoice::setSyncEnabled(bool enabled, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::Sync, enabled ? 1.0 : 0.0, offset);
+}
+
+void PolyVoice::setPitchOffset(int pitchOffset, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::PitchOffset, pitchOffset, offset);
+}
+
+void PolyVoice::setFineTune(dsp_float fine, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::FineTune, fine, offset);
+}
+
+// The frequency is set by notes when the envelopes are enabled
+void PolyVoice::setFrequency(dsp_float f, size_t offset)
+{
+    if (envelopesEnabled)
+        return;
+
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::Frequency, f, offset);
+}
+
+void PolyVoice::setNumVoices(int count, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::NumVoices, count, offset);
+}
+
+void PolyVoice::setOscillatorMix(dsp_float mix, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::OscMix, mix, offset);
+}
+
+void PolyVoice::setNoiseMix(dsp_float mix, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::NoiseMix, mix, offset);
+}
+
+void PolyVoice::setCarrierOscillatorType(CarrierOscillatiorType oscillatorType, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::CarrierType, static_cast<int>(oscillatorType), offset);
+}
+
+void PolyVoice::setModulatorOscillatorType(ModulatorOscillatorType oscillatorType, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::ModulatorType, static_cast<int>(oscillatorType), offset);
+}
+
+void PolyVoice::setNoiseType(NoiseType type)
+{
+    for (auto &slot : slots)
+        slot.voice->setNoiseType(type);
+}
+
+void PolyVoice::setDetune(dsp_float value, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::Detune, value, offset);
+}
+
+void PolyVoice::setFeedbackCarrier(dsp_float feedback, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::FeedbackCarrier, feedback, offset);
+}
+
+void PolyVoice::setFeedbackModulator(dsp_float feedback, size_t offset)
+{
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::FeedbackModulator, feedback, offset);
+}
+
+void PolyVoice::setFilterMode(FilterMode mode)
+{
+    for (auto &slot : slots)
+        slot.voice->setFilterMode(mode);
+}
+
+// Cutoff input, the filter envelopes are added per voice
+void PolyVoice::setFilterCutoff(DSPBuffer *buffer)
+{
+    cutoffBuffer = buffer;
+
+    for (auto &slot : slots)
+        slot.voice->setFilterCutoff(buffer);
+}
+
+void PolyVoice::setFilterResonance(DSPBuffer *buffer)
+{
+    for (auto &slot : slots)
+        slot.voice->setFilterResonance(buffer);
+}
+
+void PolyVoice::setFilterDrive(dsp_float value)
+{
+    for (auto &slot : slots)
+        slot.voice->setFilterDrive(value);
+}
+
+// The gate is driven by notes when the envelopes are enabled
+void PolyVoice::setGate(bool open, size_t offset)
+{
+    if (envelopesEnabled)
+        return;
+
+    for (auto &slot : slots)
+        slot.voice->schedule(VoiceEventType::Gate, open ? 1.0 : 0.0, offset);
+}
+
+// Amplitude a VCA applies to the summed output, it lets voices without envelopes sleep
+void PolyVoice::setExternalAmplitude(DSPBuffer *buffer)
+{
+    for (auto &slot : slots)
+        slot.voice->setExternalAmplitude(buffer);
+}
+
+void PolyVoice::setSmoothTime(dsp_float ms)
+{
+    for (auto &slot : slots)
+        slot.voice->setSmoothTime(ms);
+}
+
+void PolyVoice::setTileSize(int samples)
+{
+    for (auto &slot : slots)
+        slot.voice->setTileSize(samples);
+}
+
+void PolyVoice::setModulation(ModSource source, ModDestination destination, dsp_float amount)
+{
+    for (auto &slot : slots)
+        slot.voice->setModulation(source, destination, amount);
+}
+
+void PolyVoice::setModLfo(LFOParam param, dsp_float value)
+{
+    for (auto &slot : slots)
+        slot.voice->setModLfo(param, value);
+}
+
+void PolyVoice::setControlRate(int samples)
+{
+    for (auto &slot : slots)
+        slot.voice->setControlRate(samples);
+}
+
+// Sets a parameter of the ensemble on the summed output, separate outputs bypass it
+void PolyVoice::setEnsemble(EnsembleParam param, dsp_float value)
+{
+    switch (param)
+    {
+    case EnsembleParam::Mix:
+        ensemble.setMix(value);
+        break;
+    case EnsembleParam::Rate:
+        ensemble.setRate(value);
+        break;
+    case EnsembleParam::Depth:
+        ensemble.setDepth(value);
+        break;
+    case EnsembleParam::Delay:
+        ensemble.setDelay(value);
+        break;
+    }
+}
+
+// Gets a snapshot of the sound parameters of the voices
+VoiceParameters PolyVoice::getParameters() const
+{
+    return slots.front().voice->getParameters();
+}
+
+// Applies a snapshot to all voices, stops a running morph
+void PolyVoice::setParameters(const VoiceParameters &parameters)
+{
+    morphing = false;
+
+    for (auto &slot : slots)
+        slot.voice->setParameters(parameters);
+}
+
+// Stores the current sound parameters in a preset slot
+void PolyVoice::storePreset(int slot)
+{
+    presets[clamp(slot, 0, presetCount - 1)] = getParameters();
+}
+
+// Recalls a preset slot at once, stops a running morph
+void PolyVoice::recallPreset(int slot)
+{
+    setParameters(presets[clamp(slot, 0, presetCount - 1)]);
+}
+
+// Morphs from the current sound parameters to a preset slot over ms milliseconds
+void PolyVoice::morphPreset(int slot, dsp_float ms)
+{
+    const VoiceParameters &target = presets[clamp(slot, 0, presetCount - 1)];
+    dsp_float blocks = std::max(0.0, ms) * 0.001 * getSampleRate() / getBlockSize();
+
+    if (blocks < 1.0)
+    {
+        setParameters(target);
+        return;
+    }
+
+    // The oscillators of the target exist before the morph switches to them
+    for (auto &slot : slots)
+        slot.voice->prepareOscillators(static_cast<CarrierOscillatiorType>(target.carrierType),
+                                       static_cast<ModulatorOscillatorType>(target.modulatorType));
+
+    morphFrom = getParameters();
+    morphTo = target;
+    morphPosition = 0.0;
+    morphStep = 1.0 / blocks;
+    morphing = true;
+}
+
+// Applies a blend of two preset slots, amount 0 is a and 1 is b
+void PolyVoice::blendPresets(int a, int b, dsp_float amount)
+{
+    setParameters(VoiceParameters::morph(presets[clamp(a, 0, presetCount - 1)],
+                                         presets[clamp(b, 0, presetCount - 1)],
+                                         clamp(amount, 0.0, 1.0)));
+}
+
+// Advances a running preset morph by one block
+void PolyVoice::advanceMorph()
+{
+    morphPosition = std::min(1.0, morphPosition + morphStep);
+
+    VoiceParameters parameters = VoiceParameters::morph(morphFrom, morphTo, morphPosition);
+
+    for (auto &slot : slots)
+        slot.voice->setParameters(parameters);
+
+    if (morphPosition >= 1.0)
+        morphing = false;
+}
+
+// Reads the sound parameters from a shared block at the start of every block, nullptr detaches
+void PolyVoice::setParameterBlock(const ParameterBlock *block)
+{
+    parameterBlock = block;
+    blockParameters = VoiceParameters();
+    blockVersion = 0;
+
+    // The block may switch to any oscillator type at the start of a block
+    if (block)
+    {
+        for (auto &slot : slots)
+            slot.voice->prepareAllOscillators();
+    }
+}
+
+// Applies the changes of the shared parameter block
+void PolyVoice::applyParameterBlock()
+{
+    VoiceParameters parameters;
+
+    if (!parameterBlock->read(parameters, blockVersion))
+        return;
+
+    for (auto &slot : slots)
+        slot.voice->setParameters(parameters, blockParameters);
+
+    blockParameters = parameters;
+}
+
+// Sets the number of worker threads rendering the voices, 0 renders on the DSP thread
+void PolyVoice::setThreads(int count)
+{
+    threadCount = clamp(count, 0, static_cast<int>(slots.size()) - 1);
+    pool.start(threadCount, affinity);
+}
+
+// Sets the cpus the worker threads are pinned to, empty for no pinning
+void PolyVoice::setAffinity(const std::vector<int> &cpus)
+{
+    affinity = cpus;
+
+    if (threadCount > 0)
+        pool.start(threadCount, affinity);
+}
+
+// Sets the time in microseconds an idle worker spins before it parks
+void PolyVoice::setSpinTime(dsp_float us)
+{
+    pool.setSpinTime(us);
+}
+
+// Renders the awake voices in groups of LaneCount lanes, modulated voices render one by one
+void PolyVoice::setLanesEnabled(bool enabled)
+{
+    lanesEnabled = enabled;
+}
+
+// Freezes static carrier and modulator setups into a single table per voice, lane rendering plays them live
+void PolyVoice::setFreezeEnabled(bool enabled)
+{
+    for (auto &slot : slots)
+        slot.voice->setFreezeEnabled(enabled);
+}
+
+// Runs the mixer feedback and the filter of the voices at 1, 2 or 4 times their rate, oversampled voices render one by one
+void PolyVoice::setOversampling(int factor)
+{
+    for (auto &slot : slots)
+        slot.voice->setOversampling(factor);
+}
+
+// Marks a rendered slot and frees it when its released note has faded out
+void PolyVoice::finishSlot(PolySlot &slot)
+{
+    slot.rendered = true;
+
+    if (slot.note >= 0 && !slot.held && slot.voice->isIdle())
+        slot.note = -1;
+}
+
+// Renders one voice slot, runs on the DSP thread or a worker
+void PolyVoice::renderSlot(void *arg)
+{
+    PolySlot &slot = *static_cast<PolySlot *>(arg);
+    PolyVoice *engine = slot.engine;
+    Voice *voice = slot.voice;
+
+    // Sleeping voices only apply pending parameter changes, unless an event wakes them
+    bool sleeping = voice->isIdle();
+
+    voice->computeSamples();
+
+    if (sleeping && voice->isIdle())
+    {
+        slot.rendered = false;
+        return;
+    }
+
+    engine->finishSlot(slot);
+}
+
+// Renders a lane group, runs on the DSP thread or a worker
+void PolyVoice::renderGroup(void *arg)
+{
+    LaneGroup &group = *static_cast<LaneGroup *>(arg);
+    PolyVoice *engine = group.engine;
+    Voice *voices[LaneCount];
+
+    for (int i = 0; i < group.count; ++i)
+        voices[i] = group.slots[i]->voice;
+
+    group.lanes.render(voices, group.count);
+
+    for (int i = 0; i < group.count; ++i)
+        engine->finishSlot(*group.slots[i]);
+}
+
+// Groups the awake voices and renders the groups. Sleeping voices and voices
+// with scheduled events, which split their block, render alone on the DSP thread.
+void PolyVoice::renderLanes()
+{
+    int groups = 0;
+
+    for (auto &group : laneGroups)
+        group.count = 0;
+
+    for (auto &slot : slots)
+    {
+        // Lanes share one frequency and parameter set per voice and block,
+        // gliding and smoothing voices render alone
+        if (slot.voice->isIdle() || slot.voice->hasEvents() || slot.voice->isGliding() || slot.voice->isSmoothing())
+        {
+            renderSlot(&slot);
+            continue;
+        }
+
+        LaneGroup &group = laneGroups[groups];
+        group.slots[group.count++] = &slot;
+
+        if (group.count == LaneCount)
+            ++groups;
+    }
+
+    if (groups < static_cast<int>(laneGroups.size()) && laneGroups[groups].count > 0)
+        ++groups;
+
+    pool.run(&PolyVoice::renderGroup, groupArgs.data(), groups);
+}
+
+// Writes every voice to its own output channel instead of summing them, set before initialize
+void PolyVoice::setSeparateOutputs(bool enabled)
+{
+    separateOutputs = enabled;
+}
+
+// Gets the number of output channels per side, 1 for the stereo sum or the voice count
+int PolyVoice::getOutputChannels() const
+{
+    return separateOutputs ? static_cast<int>(slots.size()) : 1;
+}
+
+// Enables the quality governor, it lowers the voice quality when a block takes too long
+void PolyVoice::setGovernorEnabled(bool enabled)
+{
+    governor.setEnabled(enabled);
+
+    // Back to full quality
+    if (!enabled && governor.update(0.0, 0.0))
+        applyQuality();
+}
+
+// Sets the load (render time / deadline) the governor steps down at and the load it steps up at
+void PolyVoice::setGovernorThresholds(dsp_float high, dsp_float low)
+{
+    governor.setThresholds(high, low);
+}
+
+// Gets the current quality level, 0 is full quality, safe to call from any thread
+int PolyVoice::getQualityLevel() const
+{
+    return qualityLevel.load(std::memory_order_relaxed);
+}
+
+// Applies the quality of the governor's level to all voices
+void PolyVoice::applyQuality()
+{
+    VoiceQuality quality = QualityGovernor::getQuality(governor.getLevel());
+
+    for (auto &slot : slots)
+        slot.voice->setQuality(quality);
+
+    qualityLevel.store(governor.getLevel(), std::memory_order_relaxed);
+}
+
+// Next sample block generation
+void PolyVoice::computeSamples()
+{
+    using clock = std::chrono::steady_clock;
+
+    size_t blocksize = getBlockSize();
+    clock::time_point start;
+
+    if (governor.isEnabled())
+        start = clock::now();
+
+    if (parameterBlock)
+        applyParameterBlock();
+
+    if (morphing)
+        advanceMorph();
+
+    // The lanes render whole blocks, modulated voices run per control step and oversampled voices on their own
+    if (lanesEnabled && !slots.front().voice->isModulated() && slots.front().voice->getOversampling() == 1)
+        renderLanes();
+    else
+        pool.run(&PolyVoice::renderSlot, slotArgs.data(), static_cast<int>(slotArgs.size()));
+
+    if (separateOutputs)
+    {
+        // Each voice to its own channel, silent voices as zeros
+        for (size_t v = 0; v < slots.size(); ++v)
+        {
+            dsp_float *outL = mixBufferL.data() + v * blocksize;
+            dsp_float *outR = mixBufferR.data() + v * blocksize;
+
+            if (!slots[v].rendered)
+            {
+                std::fill(outL, outL + blocksize, 0.0);
+                std::fill(outR, outR + blocksize, 0.0);
+                continue;
+            }
+
+            const DSPBuffer &voiceL = slots[v].voice->mixBufferL;
+            const DSPBuffer &voiceR = slots[v].voice->mixBufferR;
+
+            for (size_t i = 0; i < blocksize; ++i)
+            {
+                outL[i] = voiceL[i] * gain;
+                outR[i] = voiceR[i] * gain;
+            }
+        }
+    }
+    else
+    {
+        mixBufferL.clear();
+        mixBufferR.clear();
+
+        for (auto &slot : slots)
+        {
+            if (!slot.rendered)
+                continue;
+
+            const DSPBuffer &voiceL = slot.voice->mixBufferL;
+            const DSPBuffer &voiceR = slot.voice->mixBufferR;
+
+            for (size_t i = 0; i < blocksize; ++i)
+            {
+                mixBufferL[i] += voiceL[i] * gain;
+                mixBufferR[i] += voiceR[i] * gain;
+            }
+        }
+
+        // Once on the bus instead of per voice
+        ensemble.process(mixBufferL, mixBufferR, blocksize);
+    }
+
+    // The new quality applies from the next block on, the deadline is the duration of the engine block
+    if (governor.isEnabled() &&
+        governor.update(std::chrono::duration<double>(clock::now() - start).count(), blocksize / getSampleRate()))
+        applyQuality();
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include "QualityGovernor.h"
+#include "clamp.h"
+
+// Ctor
+QualityGovernor::QualityGovernor()
+{
+}
+
+// Enables the governor, disabled it stays on full quality
+void QualityGovernor::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+
+    if (!enabled)
+    {
+        load = 0.0;
+        overBlocks = 0;
+        holdBlocks = 0;
+        settleBlocks = 0;
+    }
+}
+
+// True if the governor is enabled
+bool QualityGovernor::isEnabled() const
+{
+    return enabled;
+}
+
+// Sets the load (render time / deadline) stepping down and the load stepping up again
+void QualityGovernor::setThresholds(dsp_float high, dsp_float low)
+{
+    highLoad = clamp(high, 0.1, 2.0);
+    lowLoad = clamp(low, 0.0, highLoad);
+}
+
+// Takes the render time of the last block and the deadline, the duration of the block,
+// in seconds, true if the level changed
+bool QualityGovernor::update(double seconds, double deadline)
+{
+    int last = level;
+
+    if (!enabled)
+    {
+        level = 0;
+        return level != last;
+    }
+
+    dsp_float blockLoad = seconds / deadline;
+
+    // Follows a rising load at once and a falling load slowly
+    load = std::max(blockLoad, 0.95 * load + 0.05 * blockLoad);
+
+    long recoveryBlocks = static_cast<long>(recoveryTime * 0.001 / deadline);
+
+    if (settleBlocks > 0)
+        --settleBlocks;
+
+    if (blockLoad > highLoad)
+    {
+        ++overBlocks;
+
+        // A missed deadline steps down at once, a high load after a few blocks,
+        // a step first has to settle before the next one
+        if (settleBlocks == 0 && (overBlocks >= stepDownBlocks || blockLoad > 1.0))
+        {
+            level = std::min(level + 1, levelCount - 1);
+            overBlocks = 0;
+            settleBlocks = static_cast<long>(settleTime * 0.001 / deadline);
+        }
+
+        holdBlocks = recoveryBlocks;
+        return level != last;
+    }
+
+    overBlocks = 0;
+
+    if (load > lowLoad)
+    {
+        holdBlocks = recoveryBlocks;
+        return false;
+    }
+
+    if (holdBlocks > 0)
+    {
+        --holdBlocks;
+        return false;
+    }
+
+    if (level > 0)
+    {
+        --level;
+        holdBlocks = recoveryBlocks;
+    }
+
+    return level != last;
+}
+
+// Gets the current quality level
+int QualityGovernor::getLevel() const
+{
+    return level;
+}
+
+// Gets the smoothed load of the last blocks
+dsp_float QualityGovernor::getLoad() const
+{
+    return load;
+}
+
+// Gets the voice quality of a level: release tails, unison, feedback,
+// filter saturation and table interpolation are given up in this order
+VoiceQuality QualityGovernor::getQuality(int level)
+{
+    VoiceQuality quality;
+
+    if (level >= 1)
+        quality.tails = false;
+
+    if (level >= 2)
+        quality.maxUnison = 3;
+
+    if (level >= 3)
+        quality.feedback = false;
+
+    if (level >= 4)
+        quality.saturation = false;
+
+    if (level >= 5)
+    {
+        quality.interpolation = false;
+        quality.maxUnison = 1;
+    }
+
+    return quality;
+}
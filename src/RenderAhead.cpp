@@ -0,0 +1,316 @@
+#include <algorithm>
+#include "RenderAhead.h"
+#include "WorkerPool.h"
+#include "clamp.h"
+
+// Frames in the ring, the render thread may fall this far behind before input is dropped
+static constexpr size_t frameCount = 2 * RenderAhead::maxLatency;
+
+// Calls queued between two blocks
+static constexpr size_t commandCount = 1024;
+
+// Ctor: the engine rendered
+RenderAhead::RenderAhead(PolyVoice *engine)
+    : engine(engine), frames(frameCount), commands(commandCount)
+{
+    silence.resize(DSP::maxBlockSize);
+}
+
+// Dtor: stops the render thread
+RenderAhead::~RenderAhead()
+{
+    stop();
+}
+
+// Sets the latency in blocks, 0 renders on the DSP thread
+void RenderAhead::setLatency(int blocks)
+{
+    blocks = clamp(blocks, 0, maxLatency);
+
+    if (blocks == latency)
+        return;
+
+    latency = blocks;
+
+    if (DSP::isInitialized())
+        start();
+}
+
+// Gets the latency in blocks
+int RenderAhead::getLatency() const
+{
+    return latency;
+}
+
+// Renders the engine at the host rate divided by 1 or 2, takes effect with the next initialize.
+// Rendering ahead is only available at the host rate
+void RenderAhead::setRateDivider(int divider)
+{
+    requestedDivider = clamp(divider, 1, 2);
+}
+
+// Gets the active rate divider
+int RenderAhead::getRateDivider() const
+{
+    return divider;
+}
+
+// Stops the render thread, initializes the engine for the current host rate
+// and block size and restarts
+void RenderAhead::initialize()
+{
+    stop();
+
+    // Half rate needs an even block
+    divider = DSP::blockSize % 2 == 0 ? requestedDivider : 1;
+
+    // A running engine keeps its sound, only the rate dependent state starts over
+    VoiceParameters sound;
+
+    if (engineInitialized)
+        sound = engine->getParameters();
+
+    // The engine keeps its own rate and block size, the host settings stay untouched
+    engine->setAudioSettings(getEngineRate(), getEngineBlockSize());
+    engine->initialize();
+
+    if (engineInitialized)
+        engine->setParameters(sound);
+
+    engineInitialized = true;
+
+    if (isResampled())
+    {
+        size_t channels = engine->getOutputChannels();
+
+        engineCutoff.resize(getEngineBlockSize());
+        engineResonance.resize(getEngineBlockSize());
+        engineAmplitude.resize(getEngineBlockSize());
+        resampledL.resize(DSP::blockSize * channels);
+        resampledR.resize(DSP::blockSize * channels);
+
+        upsampler.initialize(2 * channels, getEngineBlockSize());
+
+        DSP::log("RenderAhead: rendering at %.0f Hz", getEngineRate());
+
+        if (latency > 0)
+            DSP::log("RenderAhead: rendering ahead is only available at the host rate, rendering on the DSP thread");
+    }
+
+    start();
+}
+
+// Starts the render thread for the current block size if a latency is set
+void RenderAhead::start()
+{
+    stop();
+
+    if (latency == 0 || isResampled())
+        return;
+
+    for (auto &frame : frames)
+    {
+        frame.cutoff.resize(DSP::blockSize);
+        frame.resonance.resize(DSP::blockSize);
+        frame.amplitude.resize(DSP::blockSize);
+        frame.outL.resize(DSP::blockSize * engine->getOutputChannels());
+        frame.outR.resize(DSP::blockSize * engine->getOutputChannels());
+    }
+
+    silence.resize(DSP::blockSize * engine->getOutputChannels());
+
+    pushed = 0;
+    rendered = 0;
+    consumed = 0;
+    underruns = 0;
+
+    running = true;
+    thread = std::thread(&RenderAhead::renderLoop, this);
+    WorkerPool::configureThread(thread, -1);
+
+    DSP::log("RenderAhead: rendering %i blocks ahead, %.2f ms latency", latency,
+             1000.0 * latency * DSP::blockSize / DSP::sampleRate);
+}
+
+// Stops the render thread and applies the calls still queued
+void RenderAhead::stop()
+{
+    if (!thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        running = false;
+    }
+
+    parkCondition.notify_all();
+    thread.join();
+
+    // The engine is ours again
+    applyCommands(~0ul);
+}
+
+// Next sample block: renders it or hands the input to the render thread
+// and fetches the block rendered latency blocks ago
+void RenderAhead::process(DSPBuffer &cutoff, DSPBuffer &resonance, DSPBuffer &amplitude)
+{
+    if (isResampled())
+    {
+        processResampled(cutoff, resonance, amplitude);
+        return;
+    }
+
+    if (!thread.joinable())
+    {
+        engine->setFilterCutoff(&cutoff);
+        engine->setFilterResonance(&resonance);
+        engine->setExternalAmplitude(&amplitude);
+        engine->computeSamples();
+
+        outputL = &engine->mixBufferL;
+        outputR = &engine->mixBufferR;
+        return;
+    }
+
+    // Hand over the input unless the render thread is a full ring behind
+    unsigned long frame = pushed.load(std::memory_order_relaxed);
+
+    if (frame - rendered.load(std::memory_order_acquire) < frames.size() && frame - consumed < frames.size())
+    {
+        RenderFrame &next = frames[frame % frames.size()];
+        next.cutoff.set(cutoff);
+        next.resonance.set(resonance);
+        next.amplitude.set(amplitude);
+
+        pushed.store(frame + 1);
+
+        if (parked.load())
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            parkCondition.notify_one();
+        }
+    }
+
+    outputL = &silence;
+    outputR = &silence;
+
+    // Silence until the first block is due
+    if (pushed.load(std::memory_order_relaxed) - consumed <= static_cast<unsigned long>(latency))
+        return;
+
+    // A late block is skipped to keep the latency constant
+    if (consumed < rendered.load(std::memory_order_acquire))
+    {
+        const RenderFrame &ready = frames[consumed % frames.size()];
+        outputL = &ready.outL;
+        outputR = &ready.outR;
+    }
+    else
+    {
+        ++underruns;
+
+        // Report the first and then every power of two missed blocks
+        if ((underruns & (underruns - 1)) == 0)
+            DSP::log("RenderAhead: render thread missed %lu blocks", underruns);
+    }
+
+    ++consumed;
+}
+
+// Renders a block on the DSP thread at the engine rate and resamples it to the host rate
+void RenderAhead::processResampled(DSPBuffer &cutoff, DSPBuffer &resonance, DSPBuffer &amplitude)
+{
+    size_t hostSamples = DSP::blockSize;
+    size_t samples = getEngineBlockSize();
+    size_t channels = engine->getOutputChannels();
+
+    // The control inputs are averaged over sample pairs
+    for (size_t i = 0; i < samples; ++i)
+    {
+        engineCutoff[i] = 0.5 * (cutoff[2 * i] + cutoff[2 * i + 1]);
+        engineResonance[i] = 0.5 * (resonance[2 * i] + resonance[2 * i + 1]);
+        engineAmplitude[i] = 0.5 * (amplitude[2 * i] + amplitude[2 * i + 1]);
+    }
+
+    engine->setFilterCutoff(&engineCutoff);
+    engine->setFilterResonance(&engineResonance);
+    engine->setExternalAmplitude(&engineAmplitude);
+    engine->computeSamples();
+
+    // Left channels resample as even, right channels as odd resampler channels
+    for (size_t c = 0; c < 2 * channels; ++c)
+    {
+        const DSPBuffer &input = (c % 2 == 0) ? engine->mixBufferL : engine->mixBufferR;
+        const dsp_float *in = input.data() + (c / 2) * samples;
+
+        // The resampler output is only valid until its next call
+        const dsp_float *out = upsampler.process(c, in, samples);
+
+        DSPBuffer &output = (c % 2 == 0) ? resampledL : resampledR;
+        std::copy(out, out + hostSamples, output.data() + (c / 2) * hostSamples);
+    }
+
+    outputL = &resampledL;
+    outputR = &resampledR;
+}
+
+// Output of the last processed block
+const DSPBuffer &RenderAhead::getOutputL() const
+{
+    return outputL ? *outputL : silence;
+}
+
+const DSPBuffer &RenderAhead::getOutputR() const
+{
+    return outputR ? *outputR : silence;
+}
+
+// Applies the queued calls up to the given frame
+void RenderAhead::applyCommands(unsigned long frame)
+{
+    while (RenderCommand *command = commands.front())
+    {
+        if (command->frame > frame)
+            break;
+
+        command->invoke(engine, command->closure);
+        commands.pop();
+    }
+}
+
+// Render thread main loop: wait for input, replay the calls, render
+void RenderAhead::renderLoop()
+{
+    while (running.load(std::memory_order_relaxed))
+    {
+        unsigned long frame = rendered.load(std::memory_order_relaxed);
+
+        if (frame == pushed.load())
+        {
+            parked = true;
+
+            {
+                std::unique_lock<std::mutex> lock(parkMutex);
+                parkCondition.wait(lock, [&]()
+                                   { return !running || pushed.load() != frame; });
+            }
+
+            parked = false;
+            continue;
+        }
+
+        applyCommands(frame);
+
+        RenderFrame &current = frames[frame % frames.size()];
+        engine->setFilterCutoff(&current.cutoff);
+        engine->setFilterResonance(&current.resonance);
+        engine->setExternalAmplitude(&current.amplitude);
+        engine->computeSamples();
+
+        // All output channels
+        std::copy(engine->mixBufferL.data(), engine->mixBufferL.data() + current.outL.size(), current.outL.data());
+        std::copy(engine->mixBufferR.data(), engine->mixBufferR.data() + current.outR.size(), current.outR.data());
+
+        rendered.store(frame + 1, std::memory_order_release);
+    }
+}
@@ -10,5 +10,5 @@ static dsp_float sawAmplitude(int harmonic)
 void SawWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, sawAmplitude, 0);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), sawAmplitude, 0);
 }
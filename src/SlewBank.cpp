@@ -0,0 +1,117 @@
+#include <algorithm>
+#include "SlewBank.h"
+
+// Ctor: number of channels and slew time in milliseconds
+SlewBank::SlewBank(size_t channels, dsp_float ms)
+    : slewTime(ms), current(channels, 0.0), target(channels, 0.0), increment(channels, 0.0),
+      remaining(channels, 0.0), start(channels, 0.0), step(channels, 0.0)
+{
+    calcSamples();
+}
+
+// Initializes the bank, all channels jump to 0
+void SlewBank::initialize()
+{
+    DSPObject::initialize();
+
+    std::fill(current.begin(), current.end(), 0.0);
+    std::fill(target.begin(), target.end(), 0.0);
+    std::fill(increment.begin(), increment.end(), 0.0);
+    std::fill(remaining.begin(), remaining.end(), 0.0);
+    std::fill(start.begin(), start.end(), 0.0);
+    std::fill(step.begin(), step.end(), 0.0);
+    active = 0;
+
+    calcSamples();
+}
+
+// Sets the slew time in milliseconds, 0 applies new targets at once
+void SlewBank::setSlewTime(dsp_float ms)
+{
+    slewTime = std::max(ms, 0.0);
+    calcSamples();
+}
+
+// Gets the slew time in milliseconds
+dsp_float SlewBank::getSlewTime() const
+{
+    return slewTime;
+}
+
+// Calculates the samples for the current samplerate
+void SlewBank::calcSamples()
+{
+    slewSamples = static_cast<dsp_float>(static_cast<size_t>(std::max(slewTime, 0.0) * getSampleRate() * 0.001));
+}
+
+// Sets a new target of a channel (starts smoothing)
+void SlewBank::setTarget(size_t channel, dsp_float value)
+{
+    if (slewSamples == 0.0 || value == current[channel])
+    {
+        reset(channel, value);
+        return;
+    }
+
+    if (remaining[channel] == 0.0)
+        ++active;
+
+    target[channel] = value;
+    increment[channel] = (value - current[channel]) / slewSamples;
+    remaining[channel] = slewSamples;
+}
+
+// Jumps a channel to value without slewing
+void SlewBank::reset(size_t channel, dsp_float value)
+{
+    if (remaining[channel] > 0.0)
+        --active;
+
+    current[channel] = target[channel] = start[channel] = value;
+    increment[channel] = 0.0;
+    remaining[channel] = 0.0;
+    step[channel] = 0.0;
+}
+
+// Advances all channels over the next samples in one branch free pass.
+// A slew ending within the span is spread over the whole span.
+void SlewBank::process(size_t samples)
+{
+    size_t channels = current.size();
+    dsp_float span = static_cast<dsp_float>(samples);
+    dsp_float scale = 1.0 / span;
+    size_t stillActive = 0;
+
+    dsp_float *value = current.data();
+    const dsp_float *goal = target.data();
+    const dsp_float *inc = increment.data();
+    dsp_float *left = remaining.data();
+    dsp_float *from = start.data();
+    dsp_float *slope = step.data();
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        dsp_float count = std::min(left[c], span);
+        dsp_float next = value[c] + inc[c] * count;
+
+        left[c] -= count;
+        next = (left[c] > 0.0) ? next : goal[c];
+
+        from[c] = value[c];
+        slope[c] = (next - value[c]) * scale;
+        value[c] = next;
+        stillActive += (left[c] > 0.0) ? 1 : 0;
+    }
+
+    active = stillActive;
+}
+
+// Writes the ramp of a channel over the last processed span into buffer [begin, end)
+void SlewBank::render(size_t channel, DSPBuffer &buffer, size_t begin, size_t end) const
+{
+    dsp_float value = start[channel];
+    dsp_float slope = step[channel];
+
+    for (size_t i = begin; i < end; ++i)
+        buffer[i] = value + slope * static_cast<dsp_float>(i - begin + 1);
+}
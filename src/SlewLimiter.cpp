@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <cmath>
 #include "SlewLimiter.h"
 
+// Distance left of the way when the exponential slew snaps to the target
+static constexpr dsp_float exponentialRest = 0.001;
+
 // Constructor: slewTimeMs in milliseconds
 SlewLimiter::SlewLimiter(dsp_float ms)
 {
     slewTime = ms;
+    samplerate = getSampleRate();
+    calcSamples();
 }
 
 // Initializes the slew limiter
@@ -11,11 +18,12 @@ void SlewLimiter::initialize()
 {
     DSPObject::initialize();
     
-    samplerate = DSP::sampleRate;
+    samplerate = getSampleRate();
     remaining = 0;
     current = 0.0;
     target = 0.0;
     step = 0.0;
+    idle = true;
     calcSamples();
 }
 
@@ -25,7 +33,7 @@ void SlewLimiter::setTarget(dsp_float newTarget)
     target = newTarget;
     idle = false;
 
-    if (slewSamples > 0)
+    if (slewSamples > 0 && target != current)
     {
         step = (target - current) / static_cast<dsp_float>(slewSamples);
         remaining = slewSamples;
@@ -46,10 +54,19 @@ void SlewLimiter::setSlewTime(double ms)
     calcSamples();
 }
 
+// Sets the curve, takes effect with the next target
+void SlewLimiter::setMode(SlewMode value)
+{
+    mode = value;
+}
+
 // Calculates the samples for current samplerate
 void SlewLimiter::calcSamples()
 {
-    slewSamples = static_cast<size_t>(slewTime * samplerate * 0.001);
+    slewSamples = static_cast<size_t>(std::max(slewTime, 0.0) * samplerate * 0.001);
+
+    // The distance shrinks to exponentialRest over the slew time
+    coefficient = (slewSamples > 0) ? std::exp(std::log(exponentialRest) / static_cast<dsp_float>(slewSamples)) : 0.0;
 }
 
 // Advance one sample
@@ -57,7 +74,11 @@ dsp_float SlewLimiter::process()
 {
     if (remaining > 0)
     {
-        current += step;
+        if (mode == SlewMode::Linear)
+            current += step;
+        else
+            current = target + (current - target) * coefficient;
+
         --remaining;
     }
     else
@@ -69,8 +90,41 @@ dsp_float SlewLimiter::process()
     return current;
 }
 
+// Advances samples at once, returns the value at the end of the span
+dsp_float SlewLimiter::processBlock(size_t samples)
+{
+    size_t count = std::min(samples, remaining);
+
+    if (count > 0)
+    {
+        if (mode == SlewMode::Linear)
+            current += step * static_cast<dsp_float>(count);
+        else
+            current = target + (current - target) * std::pow(coefficient, static_cast<dsp_float>(count));
+
+        remaining -= count;
+    }
+
+    if (remaining == 0)
+    {
+        current = target;
+        idle = true;
+    }
+
+    return current;
+}
+
+// Jumps to value without slewing
+void SlewLimiter::reset(dsp_float value)
+{
+    current = target = value;
+    step = 0.0;
+    remaining = 0;
+    idle = true;
+}
+
 // Restarts the process
 void SlewLimiter::restart()
 {
     setTarget(target);
-}
\ No newline at end of file
+}
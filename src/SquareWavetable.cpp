@@ -13,5 +13,5 @@ static dsp_float squareAmplitude(int harmonic)
 void SquareWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, squareAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), squareAmplitude, 0.5);
 }
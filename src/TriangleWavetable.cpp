@@ -16,5 +16,5 @@ static dsp_float trianlgeAmplitude(int harmonic)
 void TriangleWavetable::createWavetable(DSPBuffer &buffer, dsp_float frequency)
 {
     // Fill one full waveform cycle (0 to 2π) across the buffer
-    WaveformGenerator::generateWavetable(buffer, frequency, trianlgeAmplitude, 0.5);
+    WaveformGenerator::generateWavetable(buffer, frequency, getSampleRate(), trianlgeAmplitude, 0.5);
 }
@@ -1,40 +1,44 @@
 #include <cmath>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
 #include "Voice.h"
 #include "clamp.h"
 #include "VoiceOptions.h"
 #include "dsp_util.h"
 #include "dsp_types.h"
 
-// Constructor: initializes the voice with two oscillator instances.
-// These oscillators are externally allocated and represent the carrier (carrier) and modulator (modulator).
-Voice::Voice()
+// Arena capacity: each component type at most once per voice
+static constexpr size_t arenaSize =
+    VoiceArena::align(sizeof(NoiseGenerator)) +
+    VoiceArena::align(sizeof(KorgonFilter)) +
+    VoiceArena::align(sizeof(SawWavetable)) * 2 +
+    VoiceArena::align(sizeof(SquareWavetable)) * 2 +
+    VoiceArena::align(sizeof(TriangleWavetable)) * 2 +
+    VoiceArena::align(sizeof(SineWavetable)) * 2 +
+    VoiceArena::align(sizeof(HarmonicClusterWavetable)) * 2 +
+    VoiceArena::align(sizeof(FibonacciWavetable)) * 2 +
+    VoiceArena::align(sizeof(MirrorWavetable)) * 2 +
+    VoiceArena::align(sizeof(ModuloWavetable)) * 2 +
+    VoiceArena::align(sizeof(BitWavetable));
+
+// Constructor: places filter, noise and the default oscillators (saw carrier,
+// sine modulator) next to each other in the arena
+Voice::Voice() : arena(arenaSize)
 {
-    carrier = sawCarrier;
-    modulator = sineModulator;
+    filter = arena.create<KorgonFilter>();
+    noise = arena.create<NoiseGenerator>();
+
+    carrier = carrierTmp = getCarrier(CarrierOscillatiorType::Saw);
+    modulator = modulatorTmp = getModulator(ModulatorOscillatorType::Sine);
+
+    ampEnv.setStartAtCurrent(false);
+    filterEnv.setStartAtCurrent(false);
 }
 
-// Destructor: cleans up oscillator instances.
-// It is assumed that carrier and modulator were allocated using 'new' and are not shared elsewhere.
+// Destructor: the components are destroyed with the arena
 Voice::~Voice()
 {
-    delete noise;
-    delete sineCarrier;
-    delete sineModulator;
-    delete sawCarrier;
-    delete sawModulator;
-    delete squareCarrier;
-    delete squareModulator;
-    delete trianlgeCarrier;
-    delete triangleModulator;
-    delete clusterCarrier;
-    delete clusterModulator;
-    delete fibonacciCarrier;
-    delete fibonacciModulator;
-    delete mirrorCarrier;
-    delete mirrorModulator;
-    delete moduloCarrier;
-    delete moduloModulator;
-    delete bitModulator;
 }
 
 void Voice::initialize()
@@ -49,37 +53,95 @@ void Voice::initialize()
 
     DSPObject::initialize();
 
+    // The components render at the voice's sample rate and block size
+    DSPObject *components[] = {noise, filter, &ampEnv, &filterEnv, &modLfo, &glide, &bend, &smoother, &frozen};
+
+    for (auto *component : components)
+        component->setAudioSettings(getSampleRate(), getBlockSize());
+
+    for (auto *osc : carriers)
+    {
+        if (osc)
+            osc->setAudioSettings(getSampleRate(), getBlockSize());
+    }
+
+    for (auto *osc : modulators)
+    {
+        if (osc)
+            osc->setAudioSettings(getSampleRate(), getBlockSize());
+    }
+
+    smoother.initialize();
+    smoothing = false;
+
     modulationIndex = 0;
-    oscmix = 0.0;
-    noisemix = 0.0;
-    feedbackAmountCarrier = 0.0;
-    feedbackAmountModulator = 0.0;
+    setOscillatorMix(0.0);
+    setNoiseMix(0.0);
+    mixGains = mixTarget;
+    feedbackCarrier = 0.0;
+    feedbackModulator = 0.0;
+    applyFeedback();
+    lastSampleCarrierLeft = 0.0;
+    lastSampleCarrierRight = 0.0;
+    lastSampleModulatorLeft = 0.0;
+    lastSampleModulatorRight = 0.0;
 
     noise->initialize();
 
-    // Waveform generation
-    sawCarrier->initialize();
-    sawModulator->initialize();
-    sineCarrier->initialize();
-    sineModulator->initialize();
-    squareCarrier->initialize();
-    squareModulator->initialize();
-    trianlgeCarrier->initialize();
-    triangleModulator->initialize();
-    clusterCarrier->initialize();
-    clusterModulator->initialize();
-    fibonacciCarrier->initialize();
-    fibonacciModulator->initialize();
-    mirrorCarrier->initialize();
-    mirrorModulator->initialize();
-    moduloCarrier->initialize();
-    moduloModulator->initialize();
-    bitModulator->initialize();
+    // Waveform generation of the oscillators selected so far
+    for (auto *osc : carriers)
+    {
+        if (osc)
+            osc->initialize();
+    }
+
+    for (auto *osc : modulators)
+    {
+        if (osc)
+            osc->initialize();
+    }
+
+    // Oscillators selected later take their tables from here
+    loadTables();
 
     filter->initialize();
 
-    mixBufferL.resize(DSP::blockSize);
-    mixBufferR.resize(DSP::blockSize);
+    ampEnv.initialize();
+    filterEnv.initialize();
+
+    // The envelopes start on their defaults
+    VoiceParameters defaults;
+    std::copy(defaults.ampEnvelope, defaults.ampEnvelope + EnvelopeParamCount, ampEnvelope);
+    std::copy(defaults.filterEnvelope, defaults.filterEnvelope + EnvelopeParamCount, filterEnvelope);
+    drive = 0.0;
+
+    envCutoffBuffer.resize(getBlockSize());
+
+    modLfo.initialize();
+    modLfo.setIdleSignal(0.0);
+
+    glide.initialize();
+    bend.initialize();
+    pitchRamping = false;
+    modCutoffBuffer.resize(getBlockSize());
+
+    // The filter initialization resets the cutoff input
+    routeCutoff();
+
+    initializeOversampling();
+
+    componentsInitialized = true;
+
+    mixBufferL.resize(getBlockSize());
+    mixBufferR.resize(getBlockSize());
+
+    chordSize = 0;
+
+    // The tables are only allocated while freezing is enabled
+    if (freezeEnabled)
+        frozen.initialize();
+
+    frozenKey = FreezeKey();
 
     setCarrierOscillatorType(CarrierOscillatiorType::Saw);
     setModulatorOscillatorType(ModulatorOscillatorType::Sine);
@@ -92,6 +154,8 @@ void Voice::initialize()
     setNumVoices(1);
     setModIndex(0.0);
 
+    idle = false;
+
     DSP::log("=====> jpvoice initialized");
 }
 
@@ -99,8 +163,13 @@ void Voice::initialize()
 // This controls the intensity of the frequency modulation effect.
 void Voice::setModIndex(dsp_float index)
 {
+    if (smoothParam(SmoothedParam::ModIndex, index))
+        return;
+
     modulationIndex = index;
     carrier->setModIndex(modulationIndex);
+
+    wakeOnChange();
 }
 
 // Enables or disables oscillator synchronization.
@@ -108,6 +177,8 @@ void Voice::setModIndex(dsp_float index)
 void Voice::setSyncEnabled(bool enabled)
 {
     syncEnabled = enabled;
+
+    wakeOnChange();
 }
 
 // Sets the pitch offset for the modulator
@@ -115,6 +186,8 @@ void Voice::setPitchOffset(int offset)
 {
     pitchOffset = offset;
     modulator->setPitchOffset(pitchOffset);
+
+    wakeOnChange();
 }
 
 // Sets the fine tunig for the modulator
@@ -122,21 +195,120 @@ void Voice::setFineTune(dsp_float fine)
 {
     fineTune = fine;
     modulator->setFineTune(fineTune);
+
+    wakeOnChange();
 }
 
-// Sets the current frequency
+// Sets the current frequency, an awake voice glides to it within the glide time
 void Voice::setFrequency(dsp_float f)
 {
+    // A sleeping voice and a voice without pitch start at the new note
+    bool jump = idle || frequency <= 0.0 || f <= 0.0;
+
+    frequency = f;
+
+    // Key modulation source, middle C is 0
+    key = (f > 0.0) ? std::log2(f / 261.6255653) : 0.0;
+
+    if (f <= 0.0)
+        glide.reset(0.0);
+    else if (jump)
+        glide.reset(std::log2(f));
+    else
+        glide.setTarget(std::log2(f));
+
+    settlePitch();
+
+    wakeOnChange();
+}
+
+// Sets the pitch bend in semi tones, smoothed over the bend time
+void Voice::setPitchBend(dsp_float semitones)
+{
+    dsp_float octaves = semitones / 12.0;
+
+    if (idle || frequency <= 0.0)
+        bend.reset(octaves);
+    else
+        bend.setTarget(octaves);
+
+    settlePitch();
+
+    wakeOnChange();
+}
+
+// Sets the portamento time in ms and its curve, 0 jumps to a new note
+void Voice::setGlide(dsp_float ms, SlewMode mode)
+{
+    glide.setSlewTime(ms);
+    glide.setMode(mode);
+}
+
+// Sets the time in ms a pitch bend change is smoothed over
+void Voice::setBendTime(dsp_float ms)
+{
+    bend.setSlewTime(ms);
+}
+
+// True if the pitch glides or a pitch bend change is smoothed
+bool Voice::isGliding() const
+{
+    return pitchRamping || !glide.isIdle() || !bend.isIdle();
+}
+
+// Sets the unmodulated oscillator frequency, the kernels ramp it by ratio per sample
+void Voice::setOscillatorFrequency(dsp_float f, dsp_float ratio)
+{
+    currentFrequency = f;
+
     carrier->setFrequency(f);
     modulator->setFrequency(f);
-    frequency = f;
+    carrier->setFrequencyRamp(ratio);
+    modulator->setFrequencyRamp(ratio);
+}
+
+// Puts the oscillators on the note frequency with the bend once nothing glides
+void Voice::settlePitch()
+{
+    if (!glide.isIdle() || !bend.isIdle())
+        return;
+
+    setOscillatorFrequency(frequency > 0.0 ? frequency * std::exp2(bend.get()) : frequency, 1.0);
+    pitchRamping = false;
+}
+
+// Advances glide and bend over the next samples: the oscillators start at the
+// current pitch and their kernels ramp it geometrically to the pitch at the end,
+// one exp2 per tile instead of one per sample
+void Voice::rampPitch(size_t samples)
+{
+    if (!isGliding())
+        return;
+
+    if (glide.isIdle() && bend.isIdle())
+    {
+        // The last ramp ended, back to the exact frequency
+        settlePitch();
+        return;
+    }
+
+    dsp_float from = glide.get() + bend.get();
+    dsp_float to = glide.processBlock(samples) + bend.processBlock(samples);
+
+    setOscillatorFrequency(std::exp2(from), std::exp2((to - from) / static_cast<dsp_float>(samples)));
+    pitchRamping = true;
 }
 
 // Sets the detune factorjpvoice_tilde_sync
 void Voice::setDetune(dsp_float value)
 {
+    if (smoothParam(SmoothedParam::Detune, value))
+        return;
+
     detune = value;
     carrier->setDetune(detune);
+
+    wakeOnChange();
 }
 
 // Sets the number of voices
@@ -145,21 +317,73 @@ void Voice::setNumVoices(int count)
     if (count == numVoices)
         return;
 
+    int before = getUnison();
     numVoices = count;
-    paramFader.change([=]()
-                      { carrier->setNumVoices(numVoices); });
+
+    if (getUnison() != before)
+        paramFader.change([=]()
+                          { carrier->setNumVoices(getUnison()); });
+
+    wakeOnChange();
+}
+
+// Plays a paraphonic chord, pitches in semi tones relative to the voice frequency
+void Voice::setChord(const dsp_float *semitones, int count)
+{
+    int before = getUnison();
+
+    chordSize = (count < 2) ? 0 : std::min(count, WavetableOscillator::maxVoices);
+
+    for (int i = 0; i < chordSize; ++i)
+        chordRatios[i] = std::exp2(semitones[i] / 12.0);
+
+    // A new number of oscillators fades, new pitches of the same notes apply at once
+    if (getUnison() != before)
+        paramFader.change([=]()
+                          { carrier->setNumVoices(getUnison());
+                            carrier->setChord(chordRatios, chordSize); });
+    else
+        carrier->setChord(chordRatios, chordSize);
+
+    wakeOnChange();
+}
+
+// Unison voices in effect, a chord gets one oscillator per note at least
+int Voice::getUnison() const
+{
+    return std::max(std::min(numVoices, quality.maxUnison), chordSize);
 }
 
 // Sets the volume level of the oscillators
 void Voice::setOscillatorMix(dsp_float mix)
 {
-    oscmix = clamp(mix, 0.0, 1.0);
+    mix = clamp(mix, 0.0, 1.0);
+
+    if (smoothParam(SmoothedParam::OscMix, mix))
+        return;
+
+    oscmix = mix;
+
+    mixTarget.carrier = std::cos(oscmix * 0.5 * M_PI);
+    mixTarget.modulator = std::sin(oscmix * 0.5 * M_PI);
+
+    wakeOnChange();
 }
 
 // Sets the volume level of the noise generator
 void Voice::setNoiseMix(dsp_float mix)
 {
-    noisemix = clamp(mix, 0.0, 1.0);
+    mix = clamp(mix, 0.0, 1.0);
+
+    if (smoothParam(SmoothedParam::NoiseMix, mix))
+        return;
+
+    noisemix = mix;
+
+    mixTarget.osc = std::cos(noisemix * 0.5 * M_PI);
+    mixTarget.noise = std::sin(noisemix * 0.5 * M_PI);
+
+    wakeOnChange();
 }
 
 // Assigns the carrier oscillator
@@ -167,36 +391,8 @@ void Voice::setCarrierOscillatorType(CarrierOscillatiorType oscillatorType)
 {
     dsp_float f = (carrier) ? carrier->getFrequency() : 0.0;
 
-    switch (oscillatorType)
-    {
-    case CarrierOscillatiorType::Saw:
-        carrierTmp = sawCarrier;
-        break;
-    case CarrierOscillatiorType::Square:
-        carrierTmp = squareCarrier;
-        break;
-    case CarrierOscillatiorType::Triangle:
-        carrierTmp = trianlgeCarrier;
-        break;
-    case CarrierOscillatiorType::Sine:
-        carrierTmp = sineCarrier;
-        break;
-    case CarrierOscillatiorType::Cluster:
-        carrierTmp = clusterCarrier;
-        break;
-    case CarrierOscillatiorType::Fibonacci:
-        carrierTmp = fibonacciCarrier;
-        break;
-    case CarrierOscillatiorType::Mirror:
-        carrierTmp = mirrorCarrier;
-        break;
-    case CarrierOscillatiorType::Modulo:
-        carrierTmp = moduloCarrier;
-        break;
-    default:
-        carrierTmp = sawCarrier;
-        break;
-    }
+    carrierType = oscillatorType;
+    carrierTmp = getCarrier(oscillatorType);
 
     if (carrierTmp == carrier)
     {
@@ -204,9 +400,12 @@ void Voice::setCarrierOscillatorType(CarrierOscillatiorType oscillatorType)
     }
 
     carrierTmp->setFrequency(f);
+    carrierTmp->setFrequencyRamp(1.0);
     carrierTmp->setModIndex(modulationIndex);
+    carrierTmp->setModIndexRamp(0.0);
     carrierTmp->setDetune(detune);
-    carrierTmp->setNumVoices(numVoices);
+    carrierTmp->setNumVoices(getUnison());
+    carrierTmp->setChord(chordRatios, chordSize);
 
     paramFader.change([=]()
                       {
@@ -217,51 +416,23 @@ void Voice::setCarrierOscillatorType(CarrierOscillatiorType oscillatorType)
             modulator = modulatorTmp;
 
          filter->reset(); });
+
+    wakeOnChange();
 }
 
 // Assigns the modulation oscillator
 void Voice::setModulatorOscillatorType(ModulatorOscillatorType oscillatorType)
 {
-    switch (oscillatorType)
-    {
-    case ModulatorOscillatorType::Saw:
-        modulatorTmp = sawModulator;
-        break;
-    case ModulatorOscillatorType::Square:
-        modulatorTmp = squareModulator;
-        break;
-    case ModulatorOscillatorType::Triangle:
-        modulatorTmp = triangleModulator;
-        break;
-    case ModulatorOscillatorType::Sine:
-        modulatorTmp = sineModulator;
-        break;
-    case ModulatorOscillatorType::Cluster:
-        modulatorTmp = clusterModulator;
-        break;
-    case ModulatorOscillatorType::Fibonacci:
-        modulatorTmp = fibonacciModulator;
-        break;
-    case ModulatorOscillatorType::Mirror:
-        modulatorTmp = mirrorModulator;
-        break;
-    case ModulatorOscillatorType::Modulo:
-        modulatorTmp = moduloModulator;
-        break;
-    case ModulatorOscillatorType::Bit:
-        modulatorTmp = bitModulator;
-        break;
-    default:
-        modulatorTmp = sineModulator;
-        break;
-    }
+    modulatorType = oscillatorType;
+    modulatorTmp = getModulator(oscillatorType);
 
     if (modulatorTmp == modulator)
     {
         return;
     }
 
-    modulatorTmp->setFrequency(frequency);
+    modulatorTmp->setFrequency(currentFrequency);
+    modulatorTmp->setFrequencyRamp(1.0);
     modulatorTmp->setPitchOffset(pitchOffset);
     modulatorTmp->setFineTune(fineTune);
 
@@ -274,24 +445,199 @@ void Voice::setModulatorOscillatorType(ModulatorOscillatorType oscillatorType)
             modulator = modulatorTmp;
 
          filter->reset(); });
+
+    wakeOnChange();
+}
+
+// Constructs the oscillator of a carrier type, create(static_cast<T *>(nullptr)) constructs a T
+template <typename Create>
+static WavetableOscillator *createCarrier(CarrierOscillatiorType type, Create create)
+{
+    switch (type)
+    {
+    case CarrierOscillatiorType::Square:
+        return create(static_cast<SquareWavetable *>(nullptr));
+    case CarrierOscillatiorType::Triangle:
+        return create(static_cast<TriangleWavetable *>(nullptr));
+    case CarrierOscillatiorType::Sine:
+        return create(static_cast<SineWavetable *>(nullptr));
+    case CarrierOscillatiorType::Cluster:
+        return create(static_cast<HarmonicClusterWavetable *>(nullptr));
+    case CarrierOscillatiorType::Fibonacci:
+        return create(static_cast<FibonacciWavetable *>(nullptr));
+    case CarrierOscillatiorType::Mirror:
+        return create(static_cast<MirrorWavetable *>(nullptr));
+    case CarrierOscillatiorType::Modulo:
+        return create(static_cast<ModuloWavetable *>(nullptr));
+    default:
+        return create(static_cast<SawWavetable *>(nullptr));
+    }
+}
+
+// Constructs the oscillator of a modulator type, create(static_cast<T *>(nullptr)) constructs a T
+template <typename Create>
+static WavetableOscillator *createModulator(ModulatorOscillatorType type, Create create)
+{
+    switch (type)
+    {
+    case ModulatorOscillatorType::Saw:
+        return create(static_cast<SawWavetable *>(nullptr));
+    case ModulatorOscillatorType::Square:
+        return create(static_cast<SquareWavetable *>(nullptr));
+    case ModulatorOscillatorType::Triangle:
+        return create(static_cast<TriangleWavetable *>(nullptr));
+    case ModulatorOscillatorType::Cluster:
+        return create(static_cast<HarmonicClusterWavetable *>(nullptr));
+    case ModulatorOscillatorType::Fibonacci:
+        return create(static_cast<FibonacciWavetable *>(nullptr));
+    case ModulatorOscillatorType::Mirror:
+        return create(static_cast<MirrorWavetable *>(nullptr));
+    case ModulatorOscillatorType::Modulo:
+        return create(static_cast<ModuloWavetable *>(nullptr));
+    case ModulatorOscillatorType::Bit:
+        return create(static_cast<BitWavetable *>(nullptr));
+    default:
+        return create(static_cast<SineWavetable *>(nullptr));
+    }
+}
+
+// Gets the tables of an oscillator, a temporary oscillator at the sample rate of the voice loads them if it does not exist yet
+template <typename Create>
+static std::shared_ptr<const WavetableSet> tablesOf(WavetableOscillator *osc, const DSPObject &voice, Create create)
+{
+    if (osc)
+        return osc->getTables();
+
+    std::unique_ptr<WavetableOscillator> prototype(create([](auto *type) -> WavetableOscillator *
+                                                          { return new std::remove_pointer_t<decltype(type)>(); }));
+    prototype->setAudioSettings(voice.getSampleRate(), voice.getBlockSize());
+    prototype->loadTables();
+    return prototype->getTables();
+}
+
+// Takes the tables of every oscillator type, the oscillators selected later are
+// created with them and initialize without file access or table generation
+void Voice::loadTables()
+{
+    for (int i = 0; i < carrierTypeCount; ++i)
+    {
+        auto type = static_cast<CarrierOscillatiorType>(i);
+        carrierTables[i] = tablesOf(carriers[i], *this, [&](auto create)
+                                           { return createCarrier(type, create); });
+    }
+
+    for (int i = 0; i < modulatorTypeCount; ++i)
+    {
+        auto type = static_cast<ModulatorOscillatorType>(i);
+        modulatorTables[i] = tablesOf(modulators[i], *this, [&](auto create)
+                                             { return createModulator(type, create); });
+    }
+}
+
+// Creates the oscillators of a carrier and a modulator type ahead of a switch to them,
+// a switch within a block then only swaps the oscillators
+void Voice::prepareOscillators(CarrierOscillatiorType carrierType, ModulatorOscillatorType modulatorType)
+{
+    getCarrier(carrierType);
+    getModulator(modulatorType);
+}
+
+// Creates the oscillators of every type, for parameter sources that may switch to any of them
+void Voice::prepareAllOscillators()
+{
+    for (int i = 0; i < carrierTypeCount; ++i)
+        getCarrier(static_cast<CarrierOscillatiorType>(i));
+
+    for (int i = 0; i < modulatorTypeCount; ++i)
+        getModulator(static_cast<ModulatorOscillatorType>(i));
+}
+
+// Gets the carrier of a type, constructs it in the arena when first selected
+WavetableOscillator *Voice::getCarrier(CarrierOscillatiorType type)
+{
+    int index = static_cast<int>(type);
+
+    if (index < 0 || index >= carrierTypeCount)
+        index = static_cast<int>(CarrierOscillatiorType::Saw);
+
+    WavetableOscillator *&osc = carriers[index];
+
+    if (osc)
+        return osc;
+
+    osc = createCarrier(static_cast<CarrierOscillatiorType>(index), [this](auto *type) -> WavetableOscillator *
+                        { return arena.create<std::remove_pointer_t<decltype(type)>>(); });
+
+    // The tables were loaded at initialize
+    osc->setAudioSettings(getSampleRate(), getBlockSize());
+    osc->setTables(carrierTables[index]);
+
+    if (componentsInitialized)
+        osc->initialize();
+
+    applyQuality(osc);
+    return osc;
+}
+
+// Gets the modulator of a type, constructs it in the arena when first selected
+WavetableOscillator *Voice::getModulator(ModulatorOscillatorType type)
+{
+    int index = static_cast<int>(type);
+
+    if (index < 0 || index >= modulatorTypeCount)
+        index = static_cast<int>(ModulatorOscillatorType::Sine);
+
+    WavetableOscillator *&osc = modulators[index];
+
+    if (osc)
+        return osc;
+
+    osc = createModulator(static_cast<ModulatorOscillatorType>(index), [this](auto *type) -> WavetableOscillator *
+                          { return arena.create<std::remove_pointer_t<decltype(type)>>(); });
+
+    // The tables were loaded at initialize
+    osc->setAudioSettings(getSampleRate(), getBlockSize());
+    osc->setTables(modulatorTables[index]);
+
+    if (componentsInitialized)
+        osc->initialize();
+
+    applyQuality(osc);
+    return osc;
 }
 
 // Changes the current noise type (white or pink)
 void Voice::setNoiseType(NoiseType type)
 {
+    noiseType = type;
     noise->setType(type);
+
+    wakeOnChange();
 }
 
 // Sets the feedback amount for the carrier
 void Voice::setFeedbackCarrier(dsp_float feedback)
 {
-    feedbackAmountCarrier = clamp(feedback, 0.0, 2.0);
+    feedbackCarrier = clamp(feedback, 0.0, 2.0);
+    applyFeedback();
+
+    wakeOnChange();
 }
 
 // Sets the feedback amount for the modulator
 void Voice::setFeedbackModulator(dsp_float feedback)
 {
-    feedbackAmountModulator = clamp(feedback, 0.0, 2.0);
+    feedbackModulator = clamp(feedback, 0.0, 2.0);
+    applyFeedback();
+
+    wakeOnChange();
+}
+
+// Feedback in effect, the feedback paths are off on low quality
+void Voice::applyFeedback()
+{
+    feedbackAmountCarrier = quality.feedback ? feedbackCarrier : 0.0;
+    feedbackAmountModulator = quality.feedback ? feedbackModulator : 0.0;
 }
 
 // Sets the filter type
@@ -300,10 +646,11 @@ void Voice::setFilterMode(FilterMode /*mode*/)
     // TODO
 }
 
-// Sets the cutoff frequency
+// Sets the cutoff frequency, the filter envelope is added when enabled
 void Voice::setFilterCutoff(DSPBuffer *buffer)
 {
-    filter->setCutoff(buffer);
+    cutoffInput = buffer;
+    routeCutoff();
 }
 
 // Sets the filter resonance
@@ -315,70 +662,1287 @@ void Voice::setFilterResonance(DSPBuffer *buffer)
 // Sets the filter drive
 void Voice::setFilterDrive(dsp_float value)
 {
+    drive = value;
     filter->setDrive(value);
+
+    wakeOnChange();
 }
 
-// Next sample block generation
-void Voice::computeSamples()
+// Sets the amplitude a VCA outside the voice applies to its output
+void Voice::setExternalAmplitude(DSPBuffer *buffer)
+{
+    externalAmplitude = buffer;
+}
+
+// Opens or closes the note gate; opening the gate wakes an idle voice
+// and starts the envelopes, closing it releases them
+void Voice::setGate(bool open)
 {
-    modulator->generateBlock();
+    gateOpen = open;
 
-    carrier->modBufferL.switchTo(modulator->outBufferL);
-    carrier->modBufferR.switchTo(modulator->outBufferR);
+    if (gateOpen)
+        wake();
 
-    carrier->generateBlock();
+    if (!envelopesEnabled)
+        return;
 
-    if (syncEnabled && carrier->hasWrapped())
+    if (gateOpen)
     {
-        modulator->resetPhase();
-        carrier->unWrap();
+        ampEnv.triggerStart();
+        filterEnv.triggerStart();
     }
-
-    if (noisemix > 0)
+    else
     {
-        noise->generateBlock();
+        ampEnv.triggerStop();
+        filterEnv.triggerStop();
     }
+}
+
+// Enables the internal amplitude and filter envelopes driven by the gate
+void Voice::setEnvelopesEnabled(bool enabled)
+{
+    envelopesEnabled = enabled;
+    routeCutoff();
 
-    amp_carrier = std::cos(oscmix * 0.5 * M_PI);
-    amp_modulator = std::sin(oscmix * 0.5 * M_PI);
-    amp_osc_noise = std::cos(noisemix * 0.5 * M_PI);
-    amp_noise = std::sin(noisemix * 0.5 * M_PI);
+    wakeOnChange();
+}
 
-    for (size_t i = 0; i < DSP::blockSize; ++i)
+// Sets an envelope parameter
+void Voice::setEnvelope(ADSR &env, EnvelopeParam param, dsp_float value)
+{
+    switch (param)
     {
-        carrierLeft = carrier->outBufferL[i] + lastSampleCarrierLeft * feedbackAmountCarrier;
-        carrierRight = carrier->outBufferR[i] + lastSampleCarrierRight * feedbackAmountCarrier;
-        modLeft = modulator->outBufferL[i] + lastSampleModulatorLeft * feedbackAmountModulator;
-        modRight = modulator->outBufferR[i] + lastSampleModulatorRight * feedbackAmountModulator;
+    case EnvelopeParam::Attack:
+        env.setAttack(value);
+        break;
+    case EnvelopeParam::Decay:
+        env.setDecay(value);
+        break;
+    case EnvelopeParam::Sustain:
+        env.setSustain(value);
+        break;
+    case EnvelopeParam::Release:
+        env.setRelease(value);
+        break;
+    case EnvelopeParam::AttackShape:
+        env.setAttackShape(value);
+        break;
+    case EnvelopeParam::ReleaseShape:
+        env.setReleaseShape(value);
+        break;
+    case EnvelopeParam::Gain:
+        env.setGain(value);
+        break;
+    case EnvelopeParam::OneShot:
+        env.setOneShot(value != 0.0);
+        break;
+    }
+}
 
-        mixL = amp_carrier * carrierLeft + amp_modulator * modLeft;
-        mixR = amp_carrier * carrierRight + amp_modulator * modRight;
+// Sets a parameter of the amplitude envelope (VCA)
+void Voice::setAmpEnvelope(EnvelopeParam param, dsp_float value)
+{
+    ampEnvelope[static_cast<int>(param)] = value;
+    setEnvelope(ampEnv, param, value);
+}
 
-        if (feedbackAmountCarrier > 0)
-        {
-            lastSampleCarrierLeft = fast_tanh(carrierLeft);
-            lastSampleCarrierRight = fast_tanh(carrierRight);
-        }
+// Sets a parameter of the filter envelope, its output is added to the cutoff in Hz
+void Voice::setFilterEnvelope(EnvelopeParam param, dsp_float value)
+{
+    filterEnvelope[static_cast<int>(param)] = value;
+    setEnvelope(filterEnv, param, value);
+}
 
-        if (feedbackAmountModulator > 0)
-        {
-            lastSampleModulatorLeft = fast_tanh(modLeft);
-            lastSampleModulatorRight = fast_tanh(modRight);
-        }
+// Generates the envelopes and the filter envelope cutoff for the samples [start, end)
+void Voice::generateEnvelopes(size_t start, size_t end)
+{
+    filterEnv.generate(start, end);
+    ampEnv.generate(start, end);
 
-        if (noisemix > 0)
-        {
-            mixL = amp_osc_noise * mixL + amp_noise * noise->outBufferL[i];
-            mixR = amp_osc_noise * mixR + amp_noise * noise->outBufferR[i];
-        }
+    const dsp_float *fenv = filterEnv.getBuffer();
+
+    if (!cutoffInput)
+    {
+        for (size_t i = start; i < end; ++i)
+            envCutoffBuffer[i] = fenv[i];
 
-        mixBufferL[i] = mixL;
-        mixBufferR[i] = mixR;
+        return;
     }
 
-    filter->setSampleBuffers(&mixBufferL, &mixBufferR);
+    const DSPBuffer &cutoff = *cutoffInput;
 
-    filter->generateBlock();
+    for (size_t i = start; i < end; ++i)
+        envCutoffBuffer[i] = cutoff[i] + fenv[i];
+}
 
-    paramFader.processChanges(mixBufferL, mixBufferR);
+// Applies the amplitude envelope generated ahead of rendering to the output
+void Voice::applyAmpEnvelope()
+{
+    const dsp_float *aenv = ampEnv.getBuffer();
+
+    for (size_t i = 0; i < getBlockSize(); ++i)
+    {
+        mixBufferL[i] *= aenv[i];
+        mixBufferR[i] *= aenv[i];
+    }
+}
+
+// Sets the key velocity 0 - 1, a modulation source
+void Voice::setVelocity(dsp_float value)
+{
+    velocity = clamp(value, 0.0, 1.0);
+}
+
+// Routes a modulation source to a destination, amount 0 removes the route
+void Voice::setModulation(ModSource source, ModDestination destination, dsp_float amount)
+{
+    modMatrix.setAmount(source, destination, amount);
+    resetModulation();
+    routeCutoff();
+
+    wakeOnChange();
+}
+
+// Sets a parameter of the modulation LFO
+void Voice::setModLfo(LFOParam param, dsp_float value)
+{
+    switch (param)
+    {
+    case LFOParam::Frequency:
+        modLfo.setFreq(value);
+        break;
+    case LFOParam::Type:
+        modLfo.setType(static_cast<LFOType>(clamp(static_cast<int>(value), 0, static_cast<int>(LFOType::Random))));
+        break;
+    case LFOParam::Shape:
+        modLfo.setShape(value);
+        break;
+    case LFOParam::PulseWidth:
+        modLfo.setPulseWidth(value);
+        break;
+    case LFOParam::Smooth:
+        modLfo.setSmooth(value);
+        break;
+    case LFOParam::Offset:
+        modLfo.setOffset(value);
+        break;
+    case LFOParam::Depth:
+        modLfo.setDepth(value);
+        break;
+    }
+
+    wakeOnChange();
+}
+
+// Sets the samples between two evaluations of the modulation matrix
+void Voice::setControlRate(int samples)
+{
+    controlRate = static_cast<size_t>(clamp(samples, 1, static_cast<int>(DSP::maxBlockSize)));
+}
+
+// True if modulation is routed, the chain then runs per control step
+bool Voice::isModulated() const
+{
+    return modMatrix.isActive();
+}
+
+// Schedules a parameter change at a sample offset within the next block,
+// offset 0 applies it at once
+void Voice::schedule(VoiceEventType type, dsp_float value, size_t offset)
+{
+    VoiceEvent event = {std::min(offset, getBlockSize() - 1), type, value};
+
+    // An oscillator switch creates the oscillator now, the queued switch only swaps it in
+    if (type == VoiceEventType::CarrierType)
+        getCarrier(static_cast<CarrierOscillatiorType>(static_cast<int>(value)));
+    else if (type == VoiceEventType::ModulatorType)
+        getModulator(static_cast<ModulatorOscillatorType>(static_cast<int>(value)));
+
+    if (event.offset == 0 || eventCount == maxEvents)
+    {
+        applyEvent(event);
+        return;
+    }
+
+    // Behind the events at the same offset, they apply in arrival order
+    size_t i = eventCount++;
+
+    for (; i > eventIndex && events[i - 1].offset > event.offset; --i)
+        events[i] = events[i - 1];
+
+    events[i] = event;
+}
+
+// Schedules a paraphonic chord at a sample offset within the next block,
+// offset 0 applies it at once
+void Voice::scheduleChord(const dsp_float *semitones, int count, size_t offset)
+{
+    if (std::min(offset, getBlockSize() - 1) == 0 || chordCount == maxChords)
+    {
+        setChord(semitones, count);
+        return;
+    }
+
+    PendingChord &chord = chords[chordCount];
+    chord.count = clamp(count, 0, WavetableOscillator::maxVoices);
+    std::copy(semitones, semitones + chord.count, chord.semitones);
+
+    schedule(VoiceEventType::Chord, static_cast<dsp_float>(chordCount++), offset);
+}
+
+// True if scheduled events are pending for the next block
+bool Voice::hasEvents() const
+{
+    return eventIndex < eventCount;
+}
+
+// Applies the events due at offset, returns the offset of the next event or the block size
+size_t Voice::applyEvents(size_t offset)
+{
+    while (eventIndex < eventCount && events[eventIndex].offset <= offset)
+        applyEvent(events[eventIndex++]);
+
+    if (eventIndex < eventCount)
+        return events[eventIndex].offset;
+
+    eventCount = 0;
+    eventIndex = 0;
+    chordCount = 0;
+    return getBlockSize();
+}
+
+// Applies a parameter change
+void Voice::applyEvent(const VoiceEvent &event)
+{
+    switch (event.type)
+    {
+    case VoiceEventType::Gate:
+        setGate(event.value != 0.0);
+        break;
+    case VoiceEventType::Frequency:
+        setFrequency(event.value);
+        break;
+    case VoiceEventType::Velocity:
+        setVelocity(event.value);
+        break;
+    case VoiceEventType::ModIndex:
+        setModIndex(event.value);
+        break;
+    case VoiceEventType::Detune:
+        setDetune(event.value);
+        break;
+    case VoiceEventType::OscMix:
+        setOscillatorMix(event.value);
+        break;
+    case VoiceEventType::NoiseMix:
+        setNoiseMix(event.value);
+        break;
+    case VoiceEventType::PitchOffset:
+        setPitchOffset(static_cast<int>(event.value));
+        break;
+    case VoiceEventType::FineTune:
+        setFineTune(event.value);
+        break;
+    case VoiceEventType::NumVoices:
+        setNumVoices(static_cast<int>(event.value));
+        break;
+    case VoiceEventType::CarrierType:
+        setCarrierOscillatorType(static_cast<CarrierOscillatiorType>(static_cast<int>(event.value)));
+        break;
+    case VoiceEventType::ModulatorType:
+        setModulatorOscillatorType(static_cast<ModulatorOscillatorType>(static_cast<int>(event.value)));
+        break;
+    case VoiceEventType::Sync:
+        setSyncEnabled(event.value != 0.0);
+        break;
+    case VoiceEventType::FeedbackCarrier:
+        setFeedbackCarrier(event.value);
+        break;
+    case VoiceEventType::FeedbackModulator:
+        setFeedbackModulator(event.value);
+        break;
+    case VoiceEventType::PitchBend:
+        setPitchBend(event.value);
+        break;
+    case VoiceEventType::Chord:
+        setChord(chords[static_cast<size_t>(event.value)].semitones, chords[static_cast<size_t>(event.value)].count);
+        break;
+    }
+}
+
+// Connects the filter to the cutoff input, the filter envelope sum or the modulated cutoff
+void Voice::routeCutoff()
+{
+    DSPBuffer *cutoff = envelopesEnabled ? &envCutoffBuffer : cutoffInput;
+
+    if (cutoff && modMatrix.isRouted(ModDestination::Cutoff))
+        cutoff = &modCutoffBuffer;
+
+    filter->setCutoff(cutoff);
+}
+
+// Returns the destinations to their unmodulated values, the next control step modulates again
+void Voice::resetModulation()
+{
+    for (auto &value : modulation)
+        value = 0.0;
+
+    cutoffFactor = 1.0;
+
+    carrier->setFrequency(currentFrequency);
+    modulator->setFrequency(currentFrequency);
+    carrier->setModIndex(modulationIndex);
+    carrier->setDetune(detune);
+}
+
+// Ramps a mixer gain linearly from its value reached at start to target at end,
+// the mixer kernel evaluates gain + step * (i + 1)
+static void rampGain(dsp_float &gain, dsp_float &step, dsp_float target, size_t start, size_t end)
+{
+    dsp_float current = gain + step * static_cast<dsp_float>(start);
+
+    step = (target - current) / static_cast<dsp_float>(end - start);
+    gain = current - step * static_cast<dsp_float>(start);
+}
+
+// Evaluates the modulation matrix for the control step [start, end) and applies it.
+// Pitch, modulation index and detune change per step, cutoff and mixer gains are
+// interpolated linearly to audio rate.
+void Voice::modulate(size_t start, size_t end)
+{
+    dsp_float sources[ModSourceCount];
+
+    sources[static_cast<int>(ModSource::Lfo)] = modMatrix.uses(ModSource::Lfo) ? modLfo.tick(end - start) : 0.0;
+    sources[static_cast<int>(ModSource::Envelope)] = envelopesEnabled ? ampEnv.getBuffer()[end - 1] : 0.0;
+    sources[static_cast<int>(ModSource::Velocity)] = velocity;
+    sources[static_cast<int>(ModSource::Key)] = key;
+
+    modMatrix.evaluate(sources, modulation);
+
+    if (modMatrix.isRouted(ModDestination::Pitch))
+    {
+        dsp_float f = currentFrequency * std::pow(2.0, modulation[static_cast<int>(ModDestination::Pitch)] / 12.0);
+        carrier->setFrequency(f);
+        modulator->setFrequency(f);
+    }
+
+    if (modMatrix.isRouted(ModDestination::ModIndex))
+    {
+        carrier->setModIndex(modulationIndex + modulation[static_cast<int>(ModDestination::ModIndex)]);
+        carrier->setModIndexRamp(0.0);
+    }
+
+    if (modMatrix.isRouted(ModDestination::Detune))
+        carrier->setDetune(detune + modulation[static_cast<int>(ModDestination::Detune)]);
+
+    if (modMatrix.isRouted(ModDestination::OscMix) || modMatrix.isRouted(ModDestination::Noise))
+    {
+        dsp_float mix = clamp(oscmix + modulation[static_cast<int>(ModDestination::OscMix)], 0.0, 1.0);
+        dsp_float noiseMix = clamp(noisemix + modulation[static_cast<int>(ModDestination::Noise)], 0.0, 1.0);
+
+        MixGains target;
+        target.carrier = std::cos(mix * 0.5 * M_PI);
+        target.modulator = std::sin(mix * 0.5 * M_PI);
+        target.osc = std::cos(noiseMix * 0.5 * M_PI);
+        target.noise = std::sin(noiseMix * 0.5 * M_PI);
+
+        rampGain(mixStart.carrier, mixStep.carrier, target.carrier, start, end);
+        rampGain(mixStart.modulator, mixStep.modulator, target.modulator, start, end);
+        rampGain(mixStart.osc, mixStep.osc, target.osc, start, end);
+        rampGain(mixStart.noise, mixStep.noise, target.noise, start, end);
+        mixGains = target;
+    }
+
+    const DSPBuffer *cutoffBase = envelopesEnabled ? &envCutoffBuffer : cutoffInput;
+
+    if (cutoffBase && modMatrix.isRouted(ModDestination::Cutoff))
+    {
+        // Cutoff modulation in octaves
+        dsp_float factor = std::pow(2.0, modulation[static_cast<int>(ModDestination::Cutoff)]);
+        dsp_float step = (factor - cutoffFactor) / static_cast<dsp_float>(end - start);
+        const DSPBuffer &cutoff = *cutoffBase;
+
+        for (size_t i = start; i < end; ++i)
+            modCutoffBuffer[i] = cutoff[i] * (cutoffFactor + step * static_cast<dsp_float>(i - start + 1));
+
+        cutoffFactor = factor;
+    }
+}
+
+// Sets the time in ms oscillator mix, noise mix, modulation index and detune
+// changes are smoothed over, 0 applies them at once
+void Voice::setSmoothTime(dsp_float ms)
+{
+    smoother.setSlewTime(ms);
+}
+
+// True if a parameter change is smoothed
+bool Voice::isSmoothing() const
+{
+    return smoothing || !smoother.isIdle();
+}
+
+// Gets a snapshot of the sound parameters, smoothed parameters at their targets
+VoiceParameters Voice::getParameters() const
+{
+    VoiceParameters parameters;
+
+    parameters.carrierType = static_cast<int>(carrierType);
+    parameters.modulatorType = static_cast<int>(modulatorType);
+    parameters.noiseType = static_cast<int>(noiseType);
+    parameters.numVoices = numVoices;
+    parameters.pitchOffset = pitchOffset;
+    parameters.sync = syncEnabled ? 1 : 0;
+    parameters.modIndex = smoother.getTarget(static_cast<size_t>(SmoothedParam::ModIndex));
+    parameters.oscMix = smoother.getTarget(static_cast<size_t>(SmoothedParam::OscMix));
+    parameters.noiseMix = smoother.getTarget(static_cast<size_t>(SmoothedParam::NoiseMix));
+    parameters.detune = smoother.getTarget(static_cast<size_t>(SmoothedParam::Detune));
+    parameters.fineTune = fineTune;
+    parameters.feedbackCarrier = feedbackCarrier;
+    parameters.feedbackModulator = feedbackModulator;
+    parameters.drive = drive;
+
+    std::copy(ampEnvelope, ampEnvelope + EnvelopeParamCount, parameters.ampEnvelope);
+    std::copy(filterEnvelope, filterEnvelope + EnvelopeParamCount, parameters.filterEnvelope);
+
+    return parameters;
+}
+
+// Applies a snapshot in one call, only the parameters that differ are set
+void Voice::setParameters(const VoiceParameters &parameters)
+{
+    setParameters(parameters, getParameters());
+}
+
+// Applies the parameters of a snapshot that differ from a previous snapshot
+void Voice::setParameters(const VoiceParameters &parameters, const VoiceParameters &previous)
+{
+    if (parameters.carrierType != previous.carrierType)
+        setCarrierOscillatorType(static_cast<CarrierOscillatiorType>(parameters.carrierType));
+
+    if (parameters.modulatorType != previous.modulatorType)
+        setModulatorOscillatorType(static_cast<ModulatorOscillatorType>(parameters.modulatorType));
+
+    if (parameters.noiseType != previous.noiseType)
+        setNoiseType(static_cast<NoiseType>(parameters.noiseType));
+
+    if (parameters.numVoices != previous.numVoices)
+        setNumVoices(parameters.numVoices);
+
+    if (parameters.pitchOffset != previous.pitchOffset)
+        setPitchOffset(parameters.pitchOffset);
+
+    if (parameters.sync != previous.sync)
+        setSyncEnabled(parameters.sync != 0);
+
+    if (parameters.modIndex != previous.modIndex)
+        setModIndex(parameters.modIndex);
+
+    if (parameters.oscMix != previous.oscMix)
+        setOscillatorMix(parameters.oscMix);
+
+    if (parameters.noiseMix != previous.noiseMix)
+        setNoiseMix(parameters.noiseMix);
+
+    if (parameters.detune != previous.detune)
+        setDetune(parameters.detune);
+
+    if (parameters.fineTune != previous.fineTune)
+        setFineTune(parameters.fineTune);
+
+    if (parameters.feedbackCarrier != previous.feedbackCarrier)
+        setFeedbackCarrier(parameters.feedbackCarrier);
+
+    if (parameters.feedbackModulator != previous.feedbackModulator)
+        setFeedbackModulator(parameters.feedbackModulator);
+
+    if (parameters.drive != previous.drive)
+        setFilterDrive(parameters.drive);
+
+    for (int i = 0; i < EnvelopeParamCount; ++i)
+    {
+        if (parameters.ampEnvelope[i] != previous.ampEnvelope[i])
+            setAmpEnvelope(static_cast<EnvelopeParam>(i), parameters.ampEnvelope[i]);
+
+        if (parameters.filterEnvelope[i] != previous.filterEnvelope[i])
+            setFilterEnvelope(static_cast<EnvelopeParam>(i), parameters.filterEnvelope[i]);
+    }
+}
+
+// Passes a parameter change to the slew bank, false if it applies at once
+bool Voice::smoothParam(SmoothedParam param, dsp_float value)
+{
+    size_t channel = static_cast<size_t>(param);
+
+    // Nothing is audible from a sleeping voice
+    if (idle)
+    {
+        smoother.reset(channel, value);
+        return false;
+    }
+
+    smoother.setTarget(channel, value);
+    return smoother.get(channel) != value;
+}
+
+// Advances the smoothed parameters over the samples [start, end), mixer gains
+// and modulation index ramp within, detune steps per tile. The tile after the
+// last ramp holds the reached values.
+void Voice::smoothParams(size_t start, size_t end)
+{
+    if (!smoothing && smoother.isIdle())
+        return;
+
+    // A ramp in this tile needs a holding tile after it
+    smoothing = !smoother.isIdle();
+    smoother.process(end - start);
+
+    oscmix = smoother.get(static_cast<size_t>(SmoothedParam::OscMix));
+    noisemix = smoother.get(static_cast<size_t>(SmoothedParam::NoiseMix));
+
+    mixTarget.carrier = std::cos(oscmix * 0.5 * M_PI);
+    mixTarget.modulator = std::sin(oscmix * 0.5 * M_PI);
+    mixTarget.osc = std::cos(noisemix * 0.5 * M_PI);
+    mixTarget.noise = std::sin(noisemix * 0.5 * M_PI);
+
+    rampGain(mixStart.carrier, mixStep.carrier, mixTarget.carrier, start, end);
+    rampGain(mixStart.modulator, mixStep.modulator, mixTarget.modulator, start, end);
+    rampGain(mixStart.osc, mixStep.osc, mixTarget.osc, start, end);
+    rampGain(mixStart.noise, mixStep.noise, mixTarget.noise, start, end);
+    mixGains = mixTarget;
+
+    size_t index = static_cast<size_t>(SmoothedParam::ModIndex);
+    modulationIndex = smoother.get(index);
+    carrier->setModIndex(smoother.getStart(index));
+    carrier->setModIndexRamp(smoother.getStep(index));
+
+    detune = smoother.get(static_cast<size_t>(SmoothedParam::Detune));
+    carrier->setDetune(detune);
+}
+
+// Puts the smoothed parameters on their targets at once
+void Voice::settleParams()
+{
+    if (!isSmoothing())
+        return;
+
+    for (size_t channel = 0; channel < static_cast<size_t>(SmoothedParam::Count); ++channel)
+        smoother.reset(channel, smoother.getTarget(channel));
+
+    smoothing = false;
+
+    setOscillatorMix(smoother.get(static_cast<size_t>(SmoothedParam::OscMix)));
+    setNoiseMix(smoother.get(static_cast<size_t>(SmoothedParam::NoiseMix)));
+    setModIndex(smoother.get(static_cast<size_t>(SmoothedParam::ModIndex)));
+    setDetune(smoother.get(static_cast<size_t>(SmoothedParam::Detune)));
+    carrier->setModIndexRamp(0.0);
+}
+
+// Sets the tile size in samples the voice chain runs on, 0 runs each stage over the whole block
+void Voice::setTileSize(int samples)
+{
+    tileSize = static_cast<size_t>(clamp(samples, 0, static_cast<int>(DSP::maxBlockSize)));
+}
+
+// Enables freezing: a carrier and modulator setup that stays static for a while
+// is baked into one band-limited table and played with a single table read
+void Voice::setFreezeEnabled(bool enabled)
+{
+    if (enabled == freezeEnabled)
+        return;
+
+    freezeEnabled = enabled;
+    frozenKey = FreezeKey();
+
+    if (enabled && componentsInitialized)
+        frozen.initialize();
+    else
+        frozen.reset();
+}
+
+// True if the oscillators play the frozen table
+bool Voice::isFrozen() const
+{
+    return freezeEnabled && frozen.isReady();
+}
+
+// Sets the quality settings, they limit the parameters without changing them
+void Voice::setQuality(const VoiceQuality &value)
+{
+    int before = getUnison();
+    quality = value;
+
+    if (getUnison() != before)
+        paramFader.change([=]()
+                          { carrier->setNumVoices(getUnison()); });
+
+    applyFeedback();
+    filter->setSaturation(quality.saturation);
+
+    for (auto *osc : carriers)
+    {
+        if (osc)
+            applyQuality(osc);
+    }
+
+    for (auto *osc : modulators)
+    {
+        if (osc)
+            applyQuality(osc);
+    }
+}
+
+// Applies the quality settings to an oscillator
+void Voice::applyQuality(WavetableOscillator *osc)
+{
+    osc->setInterpolation(quality.interpolation);
+}
+
+// True if the voice is sleeping and only outputs silence
+bool Voice::isIdle()
+{
+    return idle;
+}
+
+// Wakes a sleeping voice, rendering continues with the next block
+void Voice::wake()
+{
+    idle = false;
+}
+
+// Wakes a sleeping voice on a parameter change that can make it audible again.
+// With the internal envelopes only the gate can, the idle envelope keeps it silent
+void Voice::wakeOnChange()
+{
+    if (!envelopesEnabled)
+        wake();
+}
+
+// Puts the voice to sleep once the gate is closed and the output is silent
+void Voice::detectSilence()
+{
+    if (gateOpen)
+        return;
+
+    // The released amplitude envelope tells when the voice has faded out,
+    // without tails once it has fallen below the tail threshold
+    if (envelopesEnabled)
+    {
+        if (ampEnv.isIdle() || (!quality.tails && std::fabs(ampEnv.getBuffer()[getBlockSize() - 1]) < tailThreshold))
+            sleep();
+
+        return;
+    }
+
+    // Without them the amplitude is applied outside the voice, the
+    // output is measured at the amplitude of the external VCA
+    dsp_float peak = 0.0;
+
+    for (size_t i = 0; i < getBlockSize(); ++i)
+    {
+        dsp_float gain = externalAmplitude ? std::fabs((*externalAmplitude)[i]) : 1.0;
+        peak = std::max(peak, gain * std::fabs(mixBufferL[i]));
+        peak = std::max(peak, gain * std::fabs(mixBufferR[i]));
+    }
+
+    if (peak < (quality.tails ? silenceThreshold : tailThreshold))
+        sleep();
+}
+
+// Puts the voice to sleep immediately
+void Voice::sleep()
+{
+    settleParams();
+    idle = true;
+
+    filter->reset();
+    lastSampleCarrierLeft = 0.0;
+    lastSampleCarrierRight = 0.0;
+    lastSampleModulatorLeft = 0.0;
+    lastSampleModulatorRight = 0.0;
+}
+
+// Prepares the next block with all pending events applied at its start and
+// generates the envelopes, returns false if the voice sleeps
+bool Voice::beginBlock()
+{
+    applyEvents(getBlockSize());
+
+    if (!prepareBlock())
+        return false;
+
+    // Generated ahead of rendering, the amplitude envelope is a modulation source too
+    if (envelopesEnabled)
+        generateEnvelopes(0, getBlockSize());
+
+    return true;
+}
+
+// Outputs silence for a sleeping voice, returns false if the voice sleeps
+bool Voice::prepareBlock()
+{
+    if (!idle)
+        return true;
+
+    // Changes queued while sleeping are applied at once, nothing is audible
+    paramFader.flush();
+    mixGains = mixTarget;
+
+    mixBufferL.clear();
+    mixBufferR.clear();
+    return false;
+}
+
+// Derives the stages needed for the samples [start, end) from the parameters
+void Voice::planBlock(size_t start, size_t end)
+{
+    // Mixer gains at the start of the span, the ramp ends at mixGains
+    dsp_float modulatorGain = mixStart.modulator + mixStep.modulator * static_cast<dsp_float>(start);
+    dsp_float noiseGain = mixStart.noise + mixStep.noise * static_cast<dsp_float>(start);
+
+    // Smoothed parameters are on their way to their targets within the span
+    bool smoothedModulator = !smoother.isIdle() && (smoother.getTarget(static_cast<size_t>(SmoothedParam::ModIndex)) > 0 ||
+                                                    smoother.getTarget(static_cast<size_t>(SmoothedParam::OscMix)) > 0);
+    bool smoothedNoise = !smoother.isIdle() && smoother.getTarget(static_cast<size_t>(SmoothedParam::NoiseMix)) > 0;
+
+    plan.modulator = modulationIndex > 0 || modulatorGain > 0 || mixGains.modulator > 0 || smoothedModulator ||
+                     modMatrix.isRouted(ModDestination::ModIndex) || modMatrix.isRouted(ModDestination::OscMix);
+    plan.noise = noiseGain > 0 || mixGains.noise > 0 || smoothedNoise || modMatrix.isRouted(ModDestination::Noise);
+    plan.feedback = feedbackAmountCarrier > 0 || (plan.modulator && feedbackAmountModulator > 0);
+    plan.filter = modMatrix.isRouted(ModDestination::Cutoff) || !filter->isOpen(start, end);
+    plan.mono = carrier->isMono() && modulator->isMono();
+    plan.frozen = false;
+}
+
+// Plays the frozen table in the samples of the current span if it still matches
+void Voice::planFreeze()
+{
+    FreezeKey key;
+
+    if (!freezeEnabled || !frozen.isReady() || !getFreezeKey(key) || !key.matches(frozenKey))
+        return;
+
+    // The modulator only keeps its phase running
+    plan.frozen = true;
+    plan.modulator = false;
+    plan.feedback = false;
+}
+
+// True if both describe the same waveform
+bool Voice::FreezeKey::matches(const FreezeKey &other) const
+{
+    // The phase offset drifts with the rounding of the phase increments
+    dsp_float drift = std::fabs(offset - other.offset);
+
+    return carrier == other.carrier && modulator == other.modulator && index == other.index &&
+           ratio == other.ratio && gain == other.gain && std::min(drift, 1.0 - drift) < 1e-6;
+}
+
+// Gets the setup of the oscillators, false if it cannot be frozen: a single voice without
+// chord, feedback, sync, smoothing, modulation or glide, a modulator an octave multiple above
+// the carrier and a modulator that is heard or modulates the carrier
+bool Voice::getFreezeKey(FreezeKey &key) const
+{
+    key = FreezeKey();
+
+    if (!carrier->isMono() || !modulator->isMono() || chordSize > 0 || syncEnabled)
+        return false;
+
+    if (feedbackAmountCarrier > 0 || feedbackAmountModulator > 0 || fineTune != 0)
+        return false;
+
+    if (pitchOffset != 0 && pitchOffset != 12 && pitchOffset != 24)
+        return false;
+
+    if (!smoother.isIdle() || smoothing || modMatrix.isActive() || isGliding())
+        return false;
+
+    if (mixStep.carrier != 0 || mixStep.modulator != 0 || mixGains.carrier <= 0)
+        return false;
+
+    if (modulationIndex <= 0 && mixGains.modulator <= 0)
+        return false;
+
+    // The modulator has to run at the ratio of the carrier frequency exactly
+    dsp_float ratio = static_cast<dsp_float>(1 << (pitchOffset / 12));
+
+    if (carrier->getCalculatedFrequency() <= 0 ||
+        modulator->getCalculatedFrequency() != ratio * carrier->getCalculatedFrequency())
+        return false;
+
+    key.carrier = carrier;
+    key.modulator = modulator;
+    key.index = modulationIndex;
+    key.ratio = ratio;
+    key.gain = mixGains.modulator / mixGains.carrier;
+    key.offset = modulator->getPhase() - key.ratio * carrier->getPhase();
+    key.offset -= std::floor(key.offset);
+    return true;
+}
+
+// Follows the setup once per block: builds the frozen table after it stayed
+// static for the freeze delay and drops it as soon as a parameter moves
+void Voice::updateFreeze()
+{
+    if (!freezeEnabled)
+        return;
+
+    FreezeKey key;
+
+    if (!getFreezeKey(key) || !key.matches(frozenKey))
+    {
+        frozen.reset();
+        frozenKey = key;
+        freezeCountdown = static_cast<long>(freezeDelay * 0.001 * getSampleRate());
+        return;
+    }
+
+    if (frozen.isReady())
+        return;
+
+    // The harmonics are added over many blocks, about 4 per 64 samples
+    if (frozen.isBuilding())
+    {
+        frozen.build(static_cast<int>(std::max<size_t>(1, getBlockSize() / 16)));
+        return;
+    }
+
+    freezeCountdown -= static_cast<long>(getBlockSize());
+
+    if (freezeCountdown > 0)
+        return;
+
+    // One cycle of the carrier phase modulated by the modulator plus the modulator mixed in
+    WavetableOscillator *carrierOsc = carrier;
+    WavetableOscillator *modulatorOsc = modulator;
+    FreezeKey setup = frozenKey;
+
+    frozen.begin([=](dsp_float phase)
+                 {
+                     dsp_float mod = modulatorOsc->lookup(setup.ratio * phase + setup.offset);
+                     return carrierOsc->lookup(phase + setup.index * mod) + setup.gain * mod; });
+}
+
+// Applies parameter fades, the amplitude envelope and idle detection after rendering
+void Voice::endBlock()
+{
+    paramFader.processChanges(mixBufferL, mixBufferR);
+
+    if (envelopesEnabled)
+        applyAmpEnvelope();
+
+    detectSilence();
+}
+
+// Starts the per block ramp of the mixer gains towards their targets
+void Voice::prepareMixGains()
+{
+    dsp_float scale = 1.0 / static_cast<dsp_float>(getBlockSize());
+
+    mixStart = mixGains;
+    mixStep.carrier = (mixTarget.carrier - mixGains.carrier) * scale;
+    mixStep.modulator = (mixTarget.modulator - mixGains.modulator) * scale;
+    mixStep.osc = (mixTarget.osc - mixGains.osc) * scale;
+    mixStep.noise = (mixTarget.noise - mixGains.noise) * scale;
+    mixGains = mixTarget;
+}
+
+// Ramps the mixer gains from offset to the end of the block towards their targets
+void Voice::retargetMixGains(size_t offset)
+{
+    size_t blocksize = getBlockSize();
+
+    rampGain(mixStart.carrier, mixStep.carrier, mixTarget.carrier, offset, blocksize);
+    rampGain(mixStart.modulator, mixStep.modulator, mixTarget.modulator, offset, blocksize);
+    rampGain(mixStart.osc, mixStep.osc, mixTarget.osc, offset, blocksize);
+    rampGain(mixStart.noise, mixStep.noise, mixTarget.noise, offset, blocksize);
+    mixGains = mixTarget;
+}
+
+// Mixer kernels indexed by [mono][modulator][feedback][noise]
+const Voice::MixKernel Voice::mixKernels[2][2][2][2] = {
+    {{{&Voice::mixKernel<false, false, false, false>, &Voice::mixKernel<false, false, true, false>},
+      {&Voice::mixKernel<false, true, false, false>, &Voice::mixKernel<false, true, true, false>}},
+     {{&Voice::mixKernel<true, false, false, false>, &Voice::mixKernel<true, false, true, false>},
+      {&Voice::mixKernel<true, true, false, false>, &Voice::mixKernel<true, true, true, false>}}},
+    {{{&Voice::mixKernel<false, false, false, true>, &Voice::mixKernel<false, false, true, true>},
+      {&Voice::mixKernel<false, true, false, true>, &Voice::mixKernel<false, true, true, true>}},
+     {{&Voice::mixKernel<true, false, false, true>, &Voice::mixKernel<true, false, true, true>},
+      {&Voice::mixKernel<true, true, false, true>, &Voice::mixKernel<true, true, true, true>}}}};
+
+// Mixer kernel for the samples [start, end) of the mix buffers: oscillator mix
+// with optional modulator, feedback and noise, the gains ramp linearly over the
+// block. Mono mixes the left channel only.
+template <bool Modulator, bool Feedback, bool Noise, bool Mono>
+void Voice::mixKernel(Voice *voice, size_t start, size_t end)
+{
+    const MixBuffers &buffers = voice->mixBuffers;
+    const dsp_float *carrierL = buffers.carrierL;
+    const dsp_float *carrierR = buffers.carrierR;
+    const dsp_float *modulatorL = buffers.modulatorL;
+    const dsp_float *modulatorR = buffers.modulatorR;
+    const dsp_float *noise = buffers.noise;
+    dsp_float *outL = buffers.outL;
+    dsp_float *outR = buffers.outR;
+
+    const MixGains gain = voice->mixStart;
+    const MixGains step = voice->mixStep;
+    const dsp_float gainScale = buffers.gainScale;
+
+    // Feedback state only follows while feedback is active
+    const dsp_float feedbackCarrier = voice->feedbackAmountCarrier;
+    const dsp_float feedbackModulator = voice->feedbackAmountModulator;
+    const bool followCarrier = feedbackCarrier > 0;
+    const bool followModulator = feedbackModulator > 0;
+
+    dsp_float lastCarrierL = voice->lastSampleCarrierLeft;
+    dsp_float lastCarrierR = voice->lastSampleCarrierRight;
+    dsp_float lastModulatorL = voice->lastSampleModulatorLeft;
+    dsp_float lastModulatorR = voice->lastSampleModulatorRight;
+
+    for (size_t i = start; i < end; ++i)
+    {
+        dsp_float n = static_cast<dsp_float>(i + 1) * gainScale;
+
+        dsp_float left = carrierL[i];
+        dsp_float right = Mono ? 0.0 : carrierR[i];
+
+        if (Feedback)
+        {
+            left += lastCarrierL * feedbackCarrier;
+            lastCarrierL = followCarrier ? fast_tanh_select(left) : lastCarrierL;
+
+            if (!Mono)
+            {
+                right += lastCarrierR * feedbackCarrier;
+                lastCarrierR = followCarrier ? fast_tanh_select(right) : lastCarrierR;
+            }
+        }
+
+        dsp_float ampCarrier = gain.carrier + step.carrier * n;
+        dsp_float mixL = ampCarrier * left;
+        dsp_float mixR = ampCarrier * right;
+
+        if (Modulator)
+        {
+            dsp_float modLeft = modulatorL[i];
+            dsp_float modRight = Mono ? 0.0 : modulatorR[i];
+
+            if (Feedback)
+            {
+                modLeft += lastModulatorL * feedbackModulator;
+                lastModulatorL = followModulator ? fast_tanh_select(modLeft) : lastModulatorL;
+
+                if (!Mono)
+                {
+                    modRight += lastModulatorR * feedbackModulator;
+                    lastModulatorR = followModulator ? fast_tanh_select(modRight) : lastModulatorR;
+                }
+            }
+
+            dsp_float ampModulator = gain.modulator + step.modulator * n;
+            mixL += ampModulator * modLeft;
+            mixR += ampModulator * modRight;
+        }
+
+        if (Noise)
+        {
+            // Noise is mono
+            dsp_float ampOsc = gain.osc + step.osc * n;
+            dsp_float ampNoise = (gain.noise + step.noise * n) * noise[i];
+            mixL = ampOsc * mixL + ampNoise;
+            mixR = ampOsc * mixR + ampNoise;
+        }
+
+        outL[i] = mixL;
+
+        if (!Mono)
+            outR[i] = mixR;
+    }
+
+    if (Feedback)
+    {
+        voice->lastSampleCarrierLeft = lastCarrierL;
+        voice->lastSampleCarrierRight = Mono ? lastCarrierL : lastCarrierR;
+        voice->lastSampleModulatorLeft = lastModulatorL;
+        voice->lastSampleModulatorRight = Mono ? lastModulatorL : lastModulatorR;
+    }
+}
+
+// Next sample block generation, the block is split at the offsets of scheduled events
+void Voice::computeSamples()
+{
+    size_t blocksize = getBlockSize();
+    size_t start = 0;
+    size_t next = applyEvents(0);
+
+    // A sleeping voice wakes at the offset of its gate event
+    while (idle && next < blocksize)
+    {
+        start = next;
+        next = applyEvents(start);
+    }
+
+    if (!prepareBlock())
+        return;
+
+    // Silence before the voice woke up
+    for (size_t i = 0; i < start; ++i)
+    {
+        mixBufferL[i] = 0.0;
+        mixBufferR[i] = 0.0;
+    }
+
+    prepareMixGains();
+    noiseGenerated = false;
+    updateFreeze();
+
+    // Modulated voices run the chain per control step
+    size_t tile = (tileSize > 0) ? tileSize : blocksize;
+
+    if (modMatrix.isActive())
+        tile = controlRate;
+
+    while (start < blocksize)
+    {
+        renderSpan(start, next, tile);
+        start = next;
+
+        if (start < blocksize)
+        {
+            next = applyEvents(start);
+            retargetMixGains(start);
+        }
+    }
+
+    endBlock();
+}
+
+// Renders the samples [start, end) with the current parameters, per tile or control step
+void Voice::renderSpan(size_t start, size_t end, size_t tile)
+{
+    if (envelopesEnabled)
+        generateEnvelopes(start, end);
+
+    planBlock(start, end);
+    planFreeze();
+
+    // A modulator that is neither heard nor modulating only keeps its phase running
+    if (!plan.modulator)
+        modulator->advancePhase(end - start);
+
+    // The noise block is generated once, at the first span that mixes it in
+    if (plan.noise && !noiseGenerated)
+    {
+        noise->generateBlock();
+        noiseGenerated = true;
+    }
+
+    MixKernel mix = mixKernels[plan.mono][plan.modulator][plan.feedback][plan.noise];
+
+    // Oversampled, the mixer and the filter run on the upsampled sources
+    DSPBuffer *filterL = &mixBufferL;
+    DSPBuffer *filterR = &mixBufferR;
+
+    if (oversampling > 1)
+    {
+        mixBuffers.carrierL = oversampled[CarrierLeft].data();
+        mixBuffers.carrierR = oversampled[CarrierRight].data();
+        mixBuffers.modulatorL = oversampled[ModulatorLeft].data();
+        mixBuffers.modulatorR = oversampled[ModulatorRight].data();
+        mixBuffers.noise = oversampled[NoiseChannel].data();
+        filterL = &oversampledMixL;
+        filterR = &oversampledMixR;
+    }
+    else
+    {
+        mixBuffers.carrierL = carrier->outBufferL.data();
+        mixBuffers.carrierR = carrier->outBufferR.data();
+        mixBuffers.modulatorL = modulator->outBufferL.data();
+        mixBuffers.modulatorR = modulator->outBufferR.data();
+        mixBuffers.noise = noise->outBufferL.data();
+    }
+
+    mixBuffers.outL = filterL->data();
+    mixBuffers.outR = filterR->data();
+    mixBuffers.gainScale = 1.0 / oversampling;
+
+    // A fully open filter passes the signal unchanged and keeps its state
+    if (plan.filter)
+        filter->setSampleBuffers(filterL, filterR);
+
+    // Run the chain per tile, the slices of the intermediate buffers stay in L1
+    bool modulated = modMatrix.isActive();
+
+    for (size_t tileStart = start; tileStart < end; tileStart += tile)
+    {
+        size_t tileEnd = std::min(tileStart + tile, end);
+
+        // Glide, bend and smoothed parameters ramp within the tile, modulation applies on top
+        rampPitch(tileEnd - tileStart);
+        smoothParams(tileStart, tileEnd);
+
+        if (modulated)
+            modulate(tileStart, tileEnd);
+
+        if (plan.mono)
+        {
+            // Single channel pipeline, the right channel is duplicated at the end
+            if (plan.frozen)
+            {
+                // One read of the frozen table, the carrier keeps its phase running
+                frozen.render(carrier->outBufferL.data(), carrier->getPhase(), carrier->getPhaseIncrement(),
+                              tileStart, tileEnd);
+                carrier->advancePhase(tileEnd - tileStart);
+            }
+            else
+            {
+                if (plan.modulator)
+                    modulator->renderMono(modulator->modBufferL, tileStart, tileEnd);
+
+                carrier->renderMono(modulator->outBufferL, tileStart, tileEnd);
+            }
+        }
+        else
+        {
+            if (plan.modulator)
+                modulator->render(modulator->modBufferL, modulator->modBufferR, tileStart, tileEnd);
+
+            // The carrier reads the modulator output directly
+            carrier->render(modulator->outBufferL, modulator->outBufferR, tileStart, tileEnd);
+        }
+
+        // The nonlinear stages, mixer feedback and filter, run at the oversampled rate
+        size_t highStart = tileStart * oversampling;
+        size_t highEnd = tileEnd * oversampling;
+
+        if (oversampling > 1)
+            upsampleSources(tileStart, tileEnd);
+
+        mix(this, highStart, highEnd);
+
+        if (plan.filter)
+        {
+            if (plan.mono)
+                filter->processMono(highStart, highEnd);
+            else
+                filter->process(highStart, highEnd);
+        }
+
+        if (oversampling > 1)
+            downsampleMix(tileStart, tileEnd);
+
+        // Sync reacts per tile, with whole block stages once per block
+        if (syncEnabled && carrier->hasWrapped())
+        {
+            modulator->resetPhase();
+            carrier->unWrap();
+        }
+    }
+
+    if (plan.mono)
+        std::copy(mixBufferL.data() + start, mixBufferL.data() + end, mixBufferR.data() + start);
+}
+
+// Upsamples the oscillator and noise outputs of the samples [start, end) the mixer reads
+void Voice::upsampleSources(size_t start, size_t end)
+{
+    unsigned channels = 1u << CarrierLeft;
+
+    if (!plan.mono)
+        channels |= 1u << CarrierRight;
+
+    if (plan.modulator)
+        channels |= plan.mono ? (1u << ModulatorLeft) : (1u << ModulatorLeft) | (1u << ModulatorRight);
+
+    if (plan.noise)
+        channels |= 1u << NoiseChannel;
+
+    // A right channel that followed the left one continues from its history, a skipped source starts over
+    unsigned resumed = channels & ~oversampledChannels;
+
+    if (resumed & (1u << CarrierRight))
+        oversampler.copy(CarrierRight, CarrierLeft);
+
+    if (resumed & (1u << ModulatorLeft))
+        oversampler.reset(ModulatorLeft);
+
+    if (resumed & (1u << ModulatorRight))
+    {
+        if (resumed & (1u << ModulatorLeft))
+            oversampler.reset(ModulatorRight);
+        else
+            oversampler.copy(ModulatorRight, ModulatorLeft);
+    }
+
+    if (resumed & (1u << NoiseChannel))
+        oversampler.reset(NoiseChannel);
+
+    oversampledChannels = channels;
+
+    const DSPBuffer *sources[OversampledChannelCount] = {&carrier->outBufferL, &carrier->outBufferR,
+                                                         &modulator->outBufferL, &modulator->outBufferR,
+                                                         &noise->outBufferL};
+    size_t samples = end - start;
+
+    for (int c = 0; c < OversampledChannelCount; ++c)
+    {
+        if (!(channels & (1u << c)))
+            continue;
+
+        // The upsampler output is only valid until its next call
+        const dsp_float *high = oversampler.upsample(c, sources[c]->data() + start, samples);
+        std::copy(high, high + samples * oversampling, oversampled[c].data() + start * oversampling);
+    }
+}
+
+// Downsamples the oversampled mix of the samples [start, end) into the mix buffers
+void Voice::downsampleMix(size_t start, size_t end)
+{
+    size_t samples = end - start;
+
+    const dsp_float *left = oversampler.downsample(CarrierLeft, oversampledMixL.data() + start * oversampling, samples);
+    std::copy(left, left + samples, mixBufferL.data() + start);
+
+    if (plan.mono)
+        return;
+
+    const dsp_float *right = oversampler.downsample(CarrierRight, oversampledMixR.data() + start * oversampling, samples);
+    std::copy(right, right + samples, mixBufferR.data() + start);
+}
+
+// Allocates the oversampled buffers for the current factor, none at factor 1
+void Voice::initializeOversampling()
+{
+    size_t samples = oversampling > 1 ? getBlockSize() * oversampling : 0;
+
+    oversampler.initialize(oversampling, OversampledChannelCount, getBlockSize());
+
+    for (auto &buffer : oversampled)
+        buffer.resize(samples);
+
+    oversampledMixL.resize(samples);
+    oversampledMixR.resize(samples);
+    oversampledChannels = 0;
+}
+
+// Runs the mixer with its feedback and the filter at 1, 2 or 4 times the sample rate against aliasing
+void Voice::setOversampling(int factor)
+{
+    factor = factor >= Oversampler::maxFactor ? Oversampler::maxFactor : (factor >= 2 ? 2 : 1);
+
+    if (factor == oversampling)
+        return;
+
+    oversampling = factor;
+    filter->setOversampling(factor);
+
+    if (componentsInitialized)
+        initializeOversampling();
+}
+
+// Gets the oversampling factor
+int Voice::getOversampling() const
+{
+    return oversampling;
 }
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include "VoiceArena.h"
+#include "DSP.h"
+
+// Ctor: reserves capacity bytes
+VoiceArena::VoiceArena(size_t capacity)
+{
+    void *block = nullptr;
+
+    if (posix_memalign(&block, alignment, align(capacity)) != 0)
+        throw std::bad_alloc();
+
+    memory = static_cast<unsigned char *>(block);
+    this->capacity = align(capacity);
+}
+
+// Dtor: destroys all objects and releases the memory
+VoiceArena::~VoiceArena()
+{
+    for (auto it = objects.rbegin(); it != objects.rend(); ++it)
+        it->destroy(it->object);
+
+    free(memory);
+}
+
+// Gets the number of bytes in use
+size_t VoiceArena::getUsed() const
+{
+    return used;
+}
+
+// Reserves size bytes aligned to a cache line
+void *VoiceArena::allocate(size_t size)
+{
+    size = align(size);
+
+    if (used + size > capacity)
+    {
+        DSP::log("VoiceArena: capacity of %zu bytes exhausted", capacity);
+        throw std::bad_alloc();
+    }
+
+    void *block = memory + used;
+    used += size;
+    return block;
+}
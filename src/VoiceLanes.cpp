@@ -0,0 +1,543 @@
+#include <cmath>
+#include <algorithm>
+#include "VoiceLanes.h"
+#include "clamp.h"
+#include "dsp_util.h"
+#include "dsp_types.h"
+
+// Lookup table of masked lanes
+static const dsp_float silentTable[1] = {0.0};
+
+// Maximum number of unison voices of a wavetable oscillator
+static constexpr int maxUnison = 9;
+
+// Branch free floor for phase wrapping
+static inline dsp_float laneFloor(dsp_float x)
+{
+    dsp_float t = static_cast<dsp_float>(static_cast<long>(x));
+    return (t > x) ? t - 1.0 : t;
+}
+
+// Initializes the lane interleaved work buffers for the sample rate and block size of the voices
+void VoiceLanes::initialize(dsp_float rate, size_t size)
+{
+    sampleRate = rate;
+    blockSize = size;
+    size *= LaneCount;
+
+    modBuffer.assign(size, 0.0);
+    leftBuffer.assign(size, 0.0);
+    rightBuffer.assign(size, 0.0);
+    noiseBuffer.assign(size, 0.0);
+    cutoffBuffer.assign(size, 0.0);
+    resoBuffer.assign(size, 0.0);
+}
+
+// Renders count (<= LaneCount) voices into their mix buffers
+void VoiceLanes::render(Voice *const *voices, int count)
+{
+    Voice *lane[LaneCount];
+    int active = 0;
+
+    // Sleeping voices leave their lane to the next voice
+    for (int i = 0; i < count && i < LaneCount; ++i)
+    {
+        if (voices[i]->beginBlock())
+        {
+            voices[i]->prepareMixGains();
+            voices[i]->planBlock(0, blockSize);
+            lane[active++] = voices[i];
+        }
+    }
+
+    if (active == 0)
+        return;
+
+    renderModulators(lane, active);
+    renderCarriers(lane, active);
+    renderMixers(lane, active);
+
+    bool filtered = false;
+
+    for (int l = 0; l < active; ++l)
+        filtered |= lane[l]->plan.filter;
+
+    if (filtered)
+        renderFilters(lane, active);
+
+    // Scatter to the voices
+    size_t blocksize = blockSize;
+
+    for (int l = 0; l < active; ++l)
+    {
+        Voice *voice = lane[l];
+
+        for (size_t i = 0; i < blocksize; ++i)
+        {
+            voice->mixBufferL[i] = leftBuffer[i * LaneCount + l];
+            voice->mixBufferR[i] = rightBuffer[i * LaneCount + l];
+        }
+
+        voice->endBlock();
+    }
+}
+
+// Modulators: plain wavetable lookup, the modulator is never modulated itself
+void VoiceLanes::renderModulators(Voice *const *lane, int active)
+{
+    alignas(64) dsp_float phase[LaneCount];
+    alignas(64) dsp_float inc[LaneCount];
+    alignas(64) dsp_float size[LaneCount];
+    alignas(64) dsp_float frac[LaneCount];
+    alignas(64) dsp_float a[LaneCount];
+    alignas(64) dsp_float b[LaneCount];
+    size_t i0[LaneCount];
+    size_t i1[LaneCount];
+    const dsp_float *table[LaneCount];
+    bool wrapped[LaneCount];
+    bool interpolated[LaneCount];
+
+    for (int l = 0; l < LaneCount; ++l)
+    {
+        // Skipped modulators only keep their phase running
+        if (l < active && lane[l]->plan.modulator)
+        {
+            WavetableOscillator *osc = lane[l]->modulator;
+            osc->prepareTable();
+
+            phase[l] = osc->currentPhase;
+            inc[l] = osc->phaseIncrement;
+            table[l] = osc->selectedWaveTable->data();
+            size[l] = static_cast<dsp_float>(osc->selectedWaveTableSize);
+            interpolated[l] = osc->interpolated;
+        }
+        else
+        {
+            phase[l] = 0.0;
+            inc[l] = 0.0;
+            table[l] = silentTable;
+            size[l] = 1.0;
+            interpolated[l] = true;
+        }
+
+        wrapped[l] = false;
+    }
+
+    size_t blocksize = blockSize;
+
+    for (size_t i = 0; i < blocksize; ++i)
+    {
+        dsp_float *out = &modBuffer[i * LaneCount];
+
+        for (int l = 0; l < LaneCount; ++l)
+        {
+            dsp_float p = phase[l] + inc[l];
+            bool w = p >= 1.0;
+            p -= w ? 1.0 : 0.0;
+            wrapped[l] |= w;
+            phase[l] = p;
+
+            dsp_float index = p * size[l];
+            dsp_float base = laneFloor(index);
+            frac[l] = index - base;
+            i0[l] = static_cast<size_t>(base);
+        }
+
+        // Gather
+        for (int l = 0; l < LaneCount; ++l)
+        {
+            size_t n = static_cast<size_t>(size[l]);
+            i0[l] = (i0[l] >= n) ? i0[l] - n : i0[l];
+            i1[l] = (i0[l] + 1 >= n) ? 0 : i0[l] + 1;
+            a[l] = table[l][i0[l]];
+            b[l] = table[l][i1[l]];
+        }
+
+        // Nearest sample on the low quality tier
+        for (int l = 0; l < LaneCount; ++l)
+            out[l] = interpolated[l] ? (1.0 - frac[l]) * a[l] + frac[l] * b[l] : a[l];
+    }
+
+    for (int l = 0; l < active; ++l)
+    {
+        WavetableOscillator *osc = lane[l]->modulator;
+
+        if (!lane[l]->plan.modulator)
+        {
+            osc->advancePhase(blockSize);
+            continue;
+        }
+
+        osc->currentPhase = phase[l];
+        osc->wrapped = wrapped[l];
+    }
+}
+
+// Carriers: phase modulated lookup of all unison voices, single voices advance
+// before the lookup, unison voices after it (as in WavetableOscillator)
+void VoiceLanes::renderCarriers(Voice *const *lane, int active)
+{
+    alignas(64) dsp_float phase[maxUnison][LaneCount];
+    alignas(64) dsp_float preInc[maxUnison][LaneCount];
+    alignas(64) dsp_float postInc[maxUnison][LaneCount];
+    alignas(64) dsp_float ampL[maxUnison][LaneCount];
+    alignas(64) dsp_float ampR[maxUnison][LaneCount];
+    alignas(64) dsp_float modIndex[LaneCount];
+    alignas(64) dsp_float size[LaneCount];
+    alignas(64) dsp_float frac[LaneCount];
+    alignas(64) dsp_float sumL[LaneCount];
+    alignas(64) dsp_float sumR[LaneCount];
+    alignas(64) dsp_float a[LaneCount];
+    alignas(64) dsp_float b[LaneCount];
+    size_t i0[LaneCount];
+    size_t i1[LaneCount];
+    const dsp_float *table[LaneCount];
+    bool wrapped[LaneCount];
+    bool interpolated[LaneCount];
+    int unison = 1;
+
+    for (int l = 0; l < LaneCount; ++l)
+    {
+        WavetableOscillator *osc = (l < active) ? lane[l]->carrier : nullptr;
+        int count = osc ? osc->numVoices : 0;
+
+        if (osc)
+        {
+            osc->prepareTable();
+            table[l] = osc->selectedWaveTable->data();
+            size[l] = static_cast<dsp_float>(osc->selectedWaveTableSize);
+            modIndex[l] = osc->modulationIndex;
+            interpolated[l] = osc->interpolated;
+            unison = std::max(unison, count);
+        }
+        else
+        {
+            table[l] = silentTable;
+            size[l] = 1.0;
+            modIndex[l] = 0.0;
+            interpolated[l] = true;
+        }
+
+        for (int k = 0; k < maxUnison; ++k)
+        {
+            phase[k][l] = preInc[k][l] = postInc[k][l] = ampL[k][l] = ampR[k][l] = 0.0;
+
+            if (k >= count)
+                continue;
+
+            if (count == 1)
+            {
+                phase[k][l] = osc->currentPhase;
+                preInc[k][l] = osc->phaseIncrement;
+                ampL[k][l] = ampR[k][l] = 1.0;
+            }
+            else
+            {
+                const WavetableVoice &v = osc->voices[k];
+                phase[k][l] = v.phase;
+                postInc[k][l] = osc->calculatedFrequency * v.pitch_ratio * (1.0 + v.detune_ratio) / sampleRate;
+                ampL[k][l] = v.amp_ratio * v.gainL;
+                ampR[k][l] = v.amp_ratio * v.gainR;
+            }
+        }
+
+        wrapped[l] = false;
+    }
+
+    size_t blocksize = blockSize;
+
+    for (size_t i = 0; i < blocksize; ++i)
+    {
+        const dsp_float *mod = &modBuffer[i * LaneCount];
+
+        for (int l = 0; l < LaneCount; ++l)
+            sumL[l] = sumR[l] = 0.0;
+
+        for (int k = 0; k < unison; ++k)
+        {
+            dsp_float *ph = phase[k];
+
+            for (int l = 0; l < LaneCount; ++l)
+            {
+                dsp_float p = ph[l] + preInc[k][l];
+                bool w = p >= 1.0;
+                p -= w ? 1.0 : 0.0;
+                wrapped[l] |= w;
+                ph[l] = p;
+
+                dsp_float m = p + modIndex[l] * mod[l];
+                m -= laneFloor(m);
+
+                dsp_float index = m * size[l];
+                dsp_float base = laneFloor(index);
+                frac[l] = index - base;
+                i0[l] = static_cast<size_t>(base);
+            }
+
+            // Gather
+            for (int l = 0; l < LaneCount; ++l)
+            {
+                size_t n = static_cast<size_t>(size[l]);
+                i0[l] = (i0[l] >= n) ? i0[l] - n : i0[l];
+                i1[l] = (i0[l] + 1 >= n) ? 0 : i0[l] + 1;
+                a[l] = table[l][i0[l]];
+                b[l] = table[l][i1[l]];
+            }
+
+            for (int l = 0; l < LaneCount; ++l)
+            {
+                dsp_float sample = interpolated[l] ? (1.0 - frac[l]) * a[l] + frac[l] * b[l] : a[l];
+                sumL[l] += sample * ampL[k][l];
+                sumR[l] += sample * ampR[k][l];
+
+                dsp_float p = ph[l] + postInc[k][l];
+                bool w = p >= 1.0;
+                p -= w ? 1.0 : 0.0;
+                wrapped[l] |= w;
+                ph[l] = p;
+            }
+        }
+
+        for (int l = 0; l < LaneCount; ++l)
+        {
+            leftBuffer[i * LaneCount + l] = sumL[l];
+            rightBuffer[i * LaneCount + l] = sumR[l];
+        }
+    }
+
+    for (int l = 0; l < active; ++l)
+    {
+        Voice *voice = lane[l];
+        WavetableOscillator *osc = voice->carrier;
+
+        if (osc->numVoices == 1)
+            osc->currentPhase = phase[0][l];
+        else
+            for (int k = 0; k < osc->numVoices; ++k)
+                osc->voices[k].phase = phase[k][l];
+
+        osc->wrapped = wrapped[l];
+
+        if (voice->syncEnabled && osc->hasWrapped())
+        {
+            voice->modulator->resetPhase();
+            osc->unWrap();
+        }
+    }
+}
+
+// Mixers: equal power oscillator and noise mix with feedback
+void VoiceLanes::renderMixers(Voice *const *lane, int active)
+{
+    alignas(64) dsp_float ampCarrier[LaneCount];
+    alignas(64) dsp_float ampModulator[LaneCount];
+    alignas(64) dsp_float ampOscNoise[LaneCount];
+    alignas(64) dsp_float ampNoise[LaneCount];
+    alignas(64) dsp_float stepCarrier[LaneCount];
+    alignas(64) dsp_float stepModulator[LaneCount];
+    alignas(64) dsp_float stepOscNoise[LaneCount];
+    alignas(64) dsp_float stepNoise[LaneCount];
+    alignas(64) dsp_float fbCarrier[LaneCount];
+    alignas(64) dsp_float fbModulator[LaneCount];
+    alignas(64) dsp_float lastCL[LaneCount];
+    alignas(64) dsp_float lastCR[LaneCount];
+    alignas(64) dsp_float lastML[LaneCount];
+    alignas(64) dsp_float lastMR[LaneCount];
+
+    size_t blocksize = blockSize;
+
+    for (int l = 0; l < LaneCount; ++l)
+    {
+        if (l < active)
+        {
+            Voice *voice = lane[l];
+
+            // Gains ramp over the block as in the scalar mixer
+            ampCarrier[l] = voice->mixStart.carrier;
+            ampModulator[l] = voice->plan.modulator ? voice->mixStart.modulator : 0.0;
+            ampOscNoise[l] = voice->mixStart.osc;
+            ampNoise[l] = voice->mixStart.noise;
+            stepCarrier[l] = voice->mixStep.carrier;
+            stepModulator[l] = voice->plan.modulator ? voice->mixStep.modulator : 0.0;
+            stepOscNoise[l] = voice->mixStep.osc;
+            stepNoise[l] = voice->mixStep.noise;
+            fbCarrier[l] = voice->feedbackAmountCarrier;
+            fbModulator[l] = voice->plan.modulator ? voice->feedbackAmountModulator : 0.0;
+            lastCL[l] = voice->lastSampleCarrierLeft;
+            lastCR[l] = voice->lastSampleCarrierRight;
+            lastML[l] = voice->lastSampleModulatorLeft;
+            lastMR[l] = voice->lastSampleModulatorRight;
+
+            // Noise is generated per voice, it is mono
+            if (voice->plan.noise)
+            {
+                voice->noise->generateBlock();
+
+                for (size_t i = 0; i < blocksize; ++i)
+                    noiseBuffer[i * LaneCount + l] = voice->noise->outBufferL[i];
+            }
+            else
+            {
+                for (size_t i = 0; i < blocksize; ++i)
+                    noiseBuffer[i * LaneCount + l] = 0.0;
+            }
+        }
+        else
+        {
+            ampCarrier[l] = ampModulator[l] = ampNoise[l] = 0.0;
+            ampOscNoise[l] = 1.0;
+            stepCarrier[l] = stepModulator[l] = stepOscNoise[l] = stepNoise[l] = 0.0;
+            fbCarrier[l] = fbModulator[l] = 0.0;
+            lastCL[l] = lastCR[l] = lastML[l] = lastMR[l] = 0.0;
+
+            for (size_t i = 0; i < blocksize; ++i)
+                noiseBuffer[i * LaneCount + l] = 0.0;
+        }
+    }
+
+    for (size_t i = 0; i < blocksize; ++i)
+    {
+        dsp_float *left = &leftBuffer[i * LaneCount];
+        dsp_float *right = &rightBuffer[i * LaneCount];
+        const dsp_float *mod = &modBuffer[i * LaneCount];
+        const dsp_float *noise = &noiseBuffer[i * LaneCount];
+        dsp_float n = static_cast<dsp_float>(i + 1);
+
+        for (int l = 0; l < LaneCount; ++l)
+        {
+            dsp_float carrierLeft = left[l] + lastCL[l] * fbCarrier[l];
+            dsp_float carrierRight = right[l] + lastCR[l] * fbCarrier[l];
+            dsp_float modLeft = mod[l] + lastML[l] * fbModulator[l];
+            dsp_float modRight = mod[l] + lastMR[l] * fbModulator[l];
+
+            dsp_float gainCarrier = ampCarrier[l] + stepCarrier[l] * n;
+            dsp_float gainModulator = ampModulator[l] + stepModulator[l] * n;
+            dsp_float mixL = gainCarrier * carrierLeft + gainModulator * modLeft;
+            dsp_float mixR = gainCarrier * carrierRight + gainModulator * modRight;
+
+            // Feedback state only follows while feedback is active
+            lastCL[l] = (fbCarrier[l] > 0) ? fast_tanh_select(carrierLeft) : lastCL[l];
+            lastCR[l] = (fbCarrier[l] > 0) ? fast_tanh_select(carrierRight) : lastCR[l];
+            lastML[l] = (fbModulator[l] > 0) ? fast_tanh_select(modLeft) : lastML[l];
+            lastMR[l] = (fbModulator[l] > 0) ? fast_tanh_select(modRight) : lastMR[l];
+
+            dsp_float gainOsc = ampOscNoise[l] + stepOscNoise[l] * n;
+            dsp_float gainNoise = (ampNoise[l] + stepNoise[l] * n) * noise[l];
+            left[l] = gainOsc * mixL + gainNoise;
+            right[l] = gainOsc * mixR + gainNoise;
+        }
+    }
+
+    for (int l = 0; l < active; ++l)
+    {
+        Voice *voice = lane[l];
+        voice->lastSampleCarrierLeft = lastCL[l];
+        voice->lastSampleCarrierRight = lastCR[l];
+        voice->lastSampleModulatorLeft = lastML[l];
+        voice->lastSampleModulatorRight = lastMR[l];
+    }
+}
+
+// Filters: KorgonFilter with per lane cutoff and resonance
+void VoiceLanes::renderFilters(Voice *const *lane, int active)
+{
+    alignas(64) dsp_float y1L[LaneCount];
+    alignas(64) dsp_float y2L[LaneCount];
+    alignas(64) dsp_float y1R[LaneCount];
+    alignas(64) dsp_float y2R[LaneCount];
+    alignas(64) dsp_float T[LaneCount];
+    alignas(64) dsp_float drive[LaneCount];
+    bool saturated[LaneCount];
+
+    size_t blocksize = blockSize;
+
+    for (int l = 0; l < LaneCount; ++l)
+    {
+        if (l < active)
+        {
+            const KorgonFilter *flt = lane[l]->filter;
+
+            y1L[l] = flt->y1L;
+            y2L[l] = flt->y2L;
+            y1R[l] = flt->y1R;
+            y2R[l] = flt->y2R;
+            T[l] = flt->T;
+            drive[l] = flt->drive;
+            saturated[l] = flt->saturated;
+
+            for (size_t i = 0; i < blocksize; ++i)
+            {
+                cutoffBuffer[i * LaneCount + l] = (*flt->cutoffBuffer)[i];
+                resoBuffer[i * LaneCount + l] = (*flt->resoBuffer)[i];
+            }
+        }
+        else
+        {
+            y1L[l] = y2L[l] = y1R[l] = y2R[l] = 0.0;
+            T[l] = 1.0 / sampleRate;
+            drive[l] = 1.0;
+            saturated[l] = true;
+
+            // Masked lanes bypass the filter
+            for (size_t i = 0; i < blocksize; ++i)
+            {
+                cutoffBuffer[i * LaneCount + l] = 20000.0;
+                resoBuffer[i * LaneCount + l] = 0.0;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < blocksize; ++i)
+    {
+        dsp_float *left = &leftBuffer[i * LaneCount];
+        dsp_float *right = &rightBuffer[i * LaneCount];
+        const dsp_float *cut = &cutoffBuffer[i * LaneCount];
+        const dsp_float *res = &resoBuffer[i * LaneCount];
+
+        for (int l = 0; l < LaneCount; ++l)
+        {
+            dsp_float cutoff = clamp(cut[l], 0.0, 20000.0);
+            bool bypass = cutoff > 15000.0;
+
+            dsp_float resoScale = (cutoff <= 2500.0) ? 1.0 : clamp(1.0 - (cutoff - 2500.0) / 7500.0, 0.0, 1.0);
+            dsp_float wc = 2.0 * M_PI * cutoff;
+            dsp_float alpha = clamp(wc * T[l] / (1.0 + wc * T[l]), 0.0, 1.0);
+            dsp_float reso = res[l] * resoScale;
+
+            // left
+            dsp_float feedback = clamp(reso * (y2L[l] - left[l]), -15.0, 15.0);
+            dsp_float a1 = y1L[l] + alpha * (left[l] - feedback - y1L[l]);
+            dsp_float a2 = y2L[l] + alpha * (a1 - y2L[l]);
+            dsp_float outL = a2 * drive[l];
+
+            // Soft clip, the filter runs linear on the low quality tier
+            dsp_float clipL = (outL >= 0.0) ? fast_tanh_select(outL) : 1.5 * fast_tanh_select(0.5 * outL);
+            outL = saturated[l] ? clipL : outL;
+
+            // right
+            feedback = clamp(reso * (y2R[l] - right[l]), -15.0, 15.0);
+            dsp_float b1 = y1R[l] + alpha * (right[l] - feedback - y1R[l]);
+            dsp_float b2 = y2R[l] + alpha * (b1 - y2R[l]);
+            dsp_float outR = b2 * drive[l];
+            dsp_float clipR = (outR >= 0.0) ? fast_tanh_select(outR) : 1.5 * fast_tanh_select(0.5 * outR);
+            outR = saturated[l] ? clipR : outR;
+
+            // Open filter passes the signal and keeps its state
+            y1L[l] = bypass ? y1L[l] : a1;
+            y2L[l] = bypass ? y2L[l] : a2;
+            y1R[l] = bypass ? y1R[l] : b1;
+            y2R[l] = bypass ? y2R[l] : b2;
+            left[l] = bypass ? left[l] : outL;
+            right[l] = bypass ? right[l] : outR;
+        }
+    }
+
+    for (int l = 0; l < active; ++l)
+    {
+        KorgonFilter *flt = lane[l]->filter;
+        flt->y1L = y1L[l];
+        flt->y2L = y2L[l];
+        flt->y1R = y1R[l];
+        flt->y2R = y2R[l];
+    }
+}
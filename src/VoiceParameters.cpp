@@ -0,0 +1,41 @@
+#include <type_traits>
+#include "VoiceParameters.h"
+#include "clamp.h"
+
+static_assert(std::is_trivially_copyable<VoiceParameters>::value, "a snapshot must be copyable with memcpy");
+
+// Linear interpolation
+static dsp_float lerp(dsp_float from, dsp_float to, dsp_float amount)
+{
+    return from + (to - from) * amount;
+}
+
+// Blends two snapshots, amount 0 is from and 1 is to. Continuous parameters
+// are interpolated linearly, discrete ones switch half way
+VoiceParameters VoiceParameters::morph(const VoiceParameters &from, const VoiceParameters &to, dsp_float amount)
+{
+    amount = clamp(amount, 0.0, 1.0);
+
+    VoiceParameters result = (amount < 0.5) ? from : to;
+
+    result.modIndex = lerp(from.modIndex, to.modIndex, amount);
+    result.oscMix = lerp(from.oscMix, to.oscMix, amount);
+    result.noiseMix = lerp(from.noiseMix, to.noiseMix, amount);
+    result.detune = lerp(from.detune, to.detune, amount);
+    result.fineTune = lerp(from.fineTune, to.fineTune, amount);
+    result.feedbackCarrier = lerp(from.feedbackCarrier, to.feedbackCarrier, amount);
+    result.feedbackModulator = lerp(from.feedbackModulator, to.feedbackModulator, amount);
+    result.drive = lerp(from.drive, to.drive, amount);
+
+    // One shot is a switch
+    for (int i = 0; i < EnvelopeParamCount; ++i)
+    {
+        if (i == static_cast<int>(EnvelopeParam::OneShot))
+            continue;
+
+        result.ampEnvelope[i] = lerp(from.ampEnvelope[i], to.ampEnvelope[i], amount);
+        result.filterEnvelope[i] = lerp(from.filterEnvelope[i], to.filterEnvelope[i], amount);
+    }
+
+    return result;
+}
@@ -6,20 +6,21 @@
 
 void WaveformGenerator::generateWavetable(DSPBuffer &buffer,
                                           dsp_float baseFrequency,
+                                          dsp_float sampleRate,
                                           AmplitudeFunction amplitudeFunc,
                                           dsp_float harmonicBoost)
 {
     size_t size = buffer.size();
 
     // Check for invalid input (no size, zero freq/sampleRate)
-    if (size == 0 || baseFrequency <= 0.0)
+    if (size == 0 || baseFrequency <= 0.0 || sampleRate <= 0.0)
     {
-        DSP::log("WaveformGenerator::generateWavetable failed: invalid buffer size or invalid frequency");
+        DSP::log("WaveformGenerator::generateWavetable failed: invalid buffer size, frequency or sample rate");
         return;
     }
 
     // Nyquist frequency: we only include harmonics below this threshold
-    const dsp_float nyquist = 0.5 * DSP::sampleRate;
+    const dsp_float nyquist = 0.5 * sampleRate;
 
     // Maximum number of harmonics allowed without aliasing
     int harmonics = static_cast<int>(nyquist / baseFrequency * (1 + clamp(harmonicBoost, 0, 1) * 9));
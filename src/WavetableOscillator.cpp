@@ -1,9 +1,12 @@
+#include <algorithm>
 #include "WavetableOscillator.h"
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sstream>
 #include <limits.h>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 
 // Ctor: expects an unique name for the waveform
 // This name is used for managiong wavetable files
@@ -23,35 +26,81 @@ WavetableOscillator::WavetableOscillator(const std::string formName)
     // Higher frequencies require higher resolution to avoid interpolation artifacts
     tableSizes = {1024, 2048, 4096, 8192, 16384};
 
-    // Initialize wavetable buffers
-    wavetableBuffers.reserve(tableSizes.size());
 }
 
+// Initializes the oscillator, takes the shared tables of the waveform at the
+// oscillator's sample rate. They are loaded or generated by the first oscillator of the waveform
 void WavetableOscillator::initialize()
 {
     DSPObject::initialize();
+    loadTables();
 
-    outBufferL.resize(DSP::blockSize);
-    outBufferR.resize(DSP::blockSize);
-    modBufferL.resize(DSP::blockSize);
-    modBufferR.resize(DSP::blockSize);
+    outBufferL.resize(getBlockSize());
+    outBufferR.resize(getBlockSize());
+    modBufferL.resize(getBlockSize());
+    modBufferR.resize(getBlockSize());
 
     setFrequency(0.0);
     setFineTune(0);
     setPitchOffset(0);
     setModIndex(0);
+    chordSize = 0;
     setNumVoices(1);
     setDetune(0.03);
     resetPhase();
 
     lastFrequency = -1.0;
+}
+
+// Takes the shared tables of the waveform at the oscillator's sample rate unless the
+// oscillator has them already, the first oscillator of the waveform loads or generates them
+void WavetableOscillator::loadTables()
+{
+    if (!tables || tables->sampleRate != getSampleRate())
+        tables = acquireTables();
+}
+
+// Gets the tables shared by the oscillators of the waveform, nullptr before they are loaded
+std::shared_ptr<const WavetableSet> WavetableOscillator::getTables() const
+{
+    return tables;
+}
+
+// Hands over the tables of another oscillator of the waveform, an initialize at their
+// sample rate then takes them without file access or table generation
+void WavetableOscillator::setTables(std::shared_ptr<const WavetableSet> shared)
+{
+    tables = shared;
+}
+
+// Gets the tables of the waveform at the oscillator's sample rate from the cache shared
+// by all oscillators, the first request loads or generates them. The lock keeps
+// concurrent requests from generating and writing the same file twice
+std::shared_ptr<const WavetableSet> WavetableOscillator::acquireTables()
+{
+    static std::mutex cacheMutex;
+    static std::map<std::string, std::shared_ptr<const WavetableSet>> cache;
+
+    std::string key = waveformName + "_" + std::to_string(static_cast<int>(getSampleRate()));
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto found = cache.find(key);
+
+    if (found != cache.end())
+        return found->second;
+
+    auto set = std::make_shared<WavetableSet>();
+    set->sampleRate = getSampleRate();
 
     DSP::log("Loading wavetable for %s", waveformName.c_str());
 
-    if (!load())
+    if (!load(*set))
     {
         DSP::log("Wavetable for %s does not exist: generating...", waveformName.c_str());
 
+        set->baseFrequencies.clear();
+        set->buffers.clear();
+
         for (size_t i = 0; i < tableSizes.size(); ++i)
         {
             size_t size = tableSizes[i];
@@ -65,13 +114,17 @@ void WavetableOscillator::initialize()
             createWavetable(*buffer, freq);
 
             // Store the buffer for later use (e.g., waveform lookup)
-            wavetableBuffers.push_back(std::move(buffer));
+            set->baseFrequencies.push_back(freq);
+            set->buffers.push_back(std::move(buffer));
         }
 
         DSP::log("Wavetable for %s generated: saving...", waveformName.c_str());
-        save();
+        save(*set);
         DSP::log("Wavetable for %s generated saved", waveformName.c_str());
     }
+
+    cache[key] = set;
+    return set;
 }
 
 // Gets the current frequency
@@ -122,7 +175,14 @@ void WavetableOscillator::setCalculatedFrequency(dsp_float f)
     calculatedFrequency = f * std::pow(2.0, semitoneOffset / 12.0);
 
     // Update phase increment for waveform generation
-    phaseIncrement = calculatedFrequency / DSP::sampleRate;
+    phaseIncrement = calculatedFrequency / getSampleRate();
+}
+
+// Sets the per sample frequency ratio of the next renders, 1 for a steady pitch.
+// The kernels ramp the frequency geometrically, a glide in the log frequency domain
+void WavetableOscillator::setFrequencyRamp(dsp_float ratio)
+{
+    frequencyRamp = ratio;
 }
 
 // Sets the modulation index for frequency modulation.
@@ -138,66 +198,101 @@ void WavetableOscillator::setModIndex(dsp_float index)
     }
 }
 
+// Sets the per sample increment of the modulation index in the next renders, 0 for a steady index.
+// The i-th sample of a render is modulated with index + step * (i + 1)
+void WavetableOscillator::setModIndexRamp(dsp_float step)
+{
+    modIndexRamp = step;
+}
+
 void WavetableOscillator::setNumVoices(int count)
 {
     // Clamp to [1, 9] and resize
-    numVoices = clamp(count, 1, 9);
+    numVoices = clamp(count, 1, maxVoices);
     voices.resize(numVoices);
 
     for (int i = 0; i < numVoices; ++i)
     {
         // Randomize phase [0.0, 1.0)
         voices[i].phase = static_cast<dsp_float>(rand()) / RAND_MAX;
-
-        // Stereo panning - from -1.0 (left) to +1.0 (right)
-        dsp_float pan = (numVoices > 1)
-                            ? static_cast<dsp_float>(i) / (numVoices - 1) * 2.0 - 1.0
-                            : 0.0;
-
-        voices[i].gainL = std::sqrt(0.5 * (1.0 - pan));
-        voices[i].gainR = std::sqrt(0.5 * (1.0 + pan));
     }
 
     // Normalize amplitude across voices
     for (int i = 0; i < numVoices; ++i)
         voices[i].amp_ratio = 3.5 / numVoices;
 
-    updateDetune(); // ensure detune_ratios match after resizing
+    updateSpread(); // ensure detune_ratios match after resizing
 }
 
-void WavetableOscillator::updateDetune()
+// Spreads the voices of every chord note in pitch and stereo, in unison all voices form one note
+void WavetableOscillator::updateSpread()
 {
-    // Detune spread from -1.0 to +1.0
-    dsp_float center = (numVoices - 1) / 2.0;
+    int notes = (chordSize > 0) ? chordSize : 1;
+
     for (int i = 0; i < numVoices; ++i)
     {
-        dsp_float offset = i - center;
-        voices[i].detune_ratio = detune * offset / center;
+        // Position of the voice among the voices of its note
+        int note = i % notes;
+        int count = (numVoices - note + notes - 1) / notes;
+        int position = i / notes;
+
+        // Detune spread from -1.0 to +1.0
+        dsp_float center = (count - 1) / 2.0;
+        dsp_float offset = position - center;
+        voices[i].detune_ratio = (count > 1) ? detune * offset / center : 0.0;
+        voices[i].pitch_ratio = (chordSize > 0) ? chordRatios[note] : 1.0;
+
+        // Stereo panning - from -1.0 (left) to +1.0 (right)
+        dsp_float pan = (count > 1)
+                            ? static_cast<dsp_float>(position) / (count - 1) * 2.0 - 1.0
+                            : 0.0;
+
+        voices[i].gainL = std::sqrt(0.5 * (1.0 - pan));
+        voices[i].gainR = std::sqrt(0.5 * (1.0 + pan));
     }
 }
 
+// Sets the pitch ratios of a paraphonic chord relative to the frequency, the unison voices
+// take the notes in turn. Fewer than two notes play every voice at the frequency
+void WavetableOscillator::setChord(const dsp_float *ratios, int count)
+{
+    chordSize = (count < 2) ? 0 : std::min(count, maxVoices);
+    std::copy(ratios, ratios + chordSize, chordRatios);
+    updateSpread();
+}
+
 void WavetableOscillator::setDetune(dsp_float value)
 {
     detune = clamp(value, 0.0, 1.0) * 0.125;
-    updateDetune();
+    updateSpread();
 }
 
 void WavetableOscillator::selectTable(double frequency)
 {
-    for (size_t i = baseFrequencies.size(); i-- > 0;)
+    for (size_t i = tables->baseFrequencies.size(); i-- > 0;)
     {
-        if (frequency >= baseFrequencies[i])
+        if (frequency >= tables->baseFrequencies[i])
         {
-            selectedWaveTable = wavetableBuffers[i].get();
+            selectedWaveTable = tables->buffers[i].get();
             selectedWaveTableSize = selectedWaveTable->size();
         }
     }
 
     // Fallback
-    selectedWaveTable = wavetableBuffers.front().get();
+    selectedWaveTable = tables->buffers.front().get();
     selectedWaveTableSize = selectedWaveTable->size();
 }
 
+// Selects the wavetable for the current frequency, a no-op if unchanged
+void WavetableOscillator::prepareTable()
+{
+    if (calculatedFrequency != lastFrequency)
+    {
+        selectTable(calculatedFrequency);
+        lastFrequency = calculatedFrequency;
+    }
+}
+
 // Returns true if the oscillator's phase wrapped during the last getSample() call
 bool WavetableOscillator::hasWrapped()
 {
@@ -217,69 +312,173 @@ void WavetableOscillator::resetPhase()
     wrapped = false;
 }
 
+// Advances the phase by samples without rendering, keeps a skipped oscillator in time
+void WavetableOscillator::advancePhase(size_t samples)
+{
+    dsp_float blocksize = static_cast<dsp_float>(samples);
+    bool wrappedFlag = false;
+
+    if (numVoices > 1)
+    {
+        for (auto &v : voices)
+        {
+            v.phase += calculatedFrequency * v.pitch_ratio * (1.0 + v.detune_ratio) / getSampleRate() * blocksize;
+            wrappedFlag |= v.phase >= 1.0;
+            v.phase -= std::floor(v.phase);
+        }
+    }
+    else
+    {
+        currentPhase += phaseIncrement * blocksize;
+        wrappedFlag = currentPhase >= 1.0;
+        currentPhase -= std::floor(currentPhase);
+    }
+
+    wrapped = wrappedFlag;
+}
+
+// Gets the phase 0 - 1 of a single voice
+dsp_float WavetableOscillator::getPhase() const
+{
+    return currentPhase;
+}
+
+// Gets the per sample phase increment of a single voice
+dsp_float WavetableOscillator::getPhaseIncrement() const
+{
+    return phaseIncrement;
+}
+
+// Reads the wavetable of the current frequency at a phase, wrapped to 0 - 1
+dsp_float WavetableOscillator::lookup(dsp_float phase)
+{
+    prepareTable();
+
+    const DSPBuffer &waveTable = *selectedWaveTable;
+
+    dsp_float index = (phase - std::floor(phase)) * selectedWaveTableSize;
+    size_t i0 = static_cast<size_t>(index) % selectedWaveTableSize;
+    size_t i1 = (i0 + 1) % selectedWaveTableSize;
+    dsp_float frac = index - std::floor(index);
+
+    return (1.0 - frac) * waveTable[i0] + frac * waveTable[i1];
+}
+
 // Next sample block generation
 void WavetableOscillator::processBlock(DSPObject *dsp)
 {
     WavetableOscillator *osc = static_cast<WavetableOscillator *>(dsp);
+    osc->render(osc->modBufferL, osc->modBufferR, 0, osc->getBlockSize());
+}
+
+// Render kernels indexed by [interpolated][unison][modulated]
+const WavetableOscillator::RenderKernel WavetableOscillator::kernels[2][2][2] = {
+    {{&WavetableOscillator::renderKernel<false, false, false, false>, &WavetableOscillator::renderKernel<false, false, true, false>},
+     {&WavetableOscillator::renderKernel<false, true, false, false>, &WavetableOscillator::renderKernel<false, true, true, false>}},
+    {{&WavetableOscillator::renderKernel<true, false, false, false>, &WavetableOscillator::renderKernel<true, false, true, false>},
+     {&WavetableOscillator::renderKernel<true, true, false, false>, &WavetableOscillator::renderKernel<true, true, true, false>}}};
+
+// Left channel only render kernels of a single voice indexed by [interpolated][modulated]
+const WavetableOscillator::RenderKernel WavetableOscillator::monoKernels[2][2] = {
+    {&WavetableOscillator::renderKernel<false, false, false, true>, &WavetableOscillator::renderKernel<false, false, true, true>},
+    {&WavetableOscillator::renderKernel<true, false, false, true>, &WavetableOscillator::renderKernel<true, false, true, true>}};
+
+// Renders the samples [start, end) of the next block phase modulated by modL/modR,
+// wrap detection accumulates over the spans of a block
+void WavetableOscillator::render(const DSPBuffer &modL, const DSPBuffer &modR, size_t start, size_t end)
+{
+    // Select the wavetable when the frequency changed, within a block too
+    prepareTable();
+
+    if (start == 0)
+        wrapped = false;
+
+    kernels[interpolated][numVoices > 1][modulationIndex != 0 || modIndexRamp != 0](this, modL, modR, start, end);
+}
+
+// Enables linear interpolation between table samples, off reads the nearest sample
+void WavetableOscillator::setInterpolation(bool enabled)
+{
+    interpolated = enabled;
+}
+
+// True if the output is mono for a mono modulation input (single voice)
+bool WavetableOscillator::isMono() const
+{
+    return numVoices == 1;
+}
+
+// Renders the samples [start, end) of a mono oscillator into outBufferL only
+void WavetableOscillator::renderMono(const DSPBuffer &mod, size_t start, size_t end)
+{
+    prepareTable();
+
+    if (start == 0)
+        wrapped = false;
+
+    monoKernels[interpolated][modulationIndex != 0 || modIndexRamp != 0](this, mod, mod, start, end);
+}
 
-    size_t blocksize = DSP::blockSize;
+// Render kernel specialised for table interpolation, unison, phase modulation and left channel only output
+template <bool Interpolated, bool Unison, bool Modulated, bool Mono>
+void WavetableOscillator::renderKernel(WavetableOscillator *osc, const DSPBuffer &modBufferL, const DSPBuffer &modBufferR,
+                                       size_t start, size_t end)
+{
     dsp_float mod_index = osc->modulationIndex;
     dsp_float phase = osc->currentPhase;
-    dsp_float frequency = osc->getCalculatedFrequency();
+    dsp_float frequency = osc->calculatedFrequency;
     bool wrappedFlag = false;
     dsp_float phaseIncrement = osc->phaseIncrement;
+    dsp_float ramp = osc->frequencyRamp;
+    dsp_float indexRamp = osc->modIndexRamp;
+    dsp_float rate = osc->getSampleRate();
 
-    DSPBuffer& modBufferL = osc->modBufferL;
-    DSPBuffer& modBufferR = osc->modBufferR;
-
-    DSPBuffer& outBufferL = osc->outBufferL;
-    DSPBuffer& outBufferR = osc->outBufferR;
-
-    // Select wavetable once per sample block
-    if (frequency != osc->lastFrequency)
-    {
-        osc->selectTable(frequency);
-        osc->lastFrequency = frequency;
-    }
+    DSPBuffer &outBufferL = osc->outBufferL;
+    DSPBuffer &outBufferR = osc->outBufferR;
 
     const DSPBuffer &waveTable = *(osc->selectedWaveTable);
     size_t waveTableSize = osc->selectedWaveTableSize;
 
-    for (size_t i = 0; i < blocksize; ++i)
+    for (size_t i = start; i < end; ++i)
     {
-        dsp_float modLeft = modBufferL[i];
-        dsp_float modRight = modBufferR[i];
+        if (Modulated)
+            mod_index += indexRamp;
 
-        if (osc->numVoices > 1)
+        if (Unison)
         {
             dsp_float sumL = 0.0;
             dsp_float sumR = 0.0;
 
             for (auto &v : osc->voices)
             {
-                dsp_float voiceFreq = frequency * (1.0 + v.detune_ratio);
+                dsp_float voiceFreq = frequency * v.pitch_ratio * (1.0 + v.detune_ratio);
 
-                // Modulation
-                dsp_float modSignal = (v.gainL > v.gainR) ? modLeft : modRight;
+                dsp_float modulatedPhase = v.phase;
 
-                // Phase modulation
-                dsp_float modulatedPhase = v.phase + mod_index * modSignal;
-                modulatedPhase -= std::floor(modulatedPhase); // Wrap to [0, 1)
+                if (Modulated)
+                {
+                    // Modulation
+                    dsp_float modSignal = (v.gainL > v.gainR) ? modBufferL[i] : modBufferR[i];
+
+                    // Phase modulation
+                    modulatedPhase += mod_index * modSignal;
+                    modulatedPhase -= std::floor(modulatedPhase); // Wrap to [0, 1)
+                }
 
                 dsp_float index = modulatedPhase * waveTableSize;
                 size_t i0 = static_cast<size_t>(index);
                 size_t i1 = (i0 + 1) % waveTableSize;
                 dsp_float frac = index - i0;
 
-                // Interpolation
-                dsp_float sample = (1.0 - frac) * waveTable[i0] + frac * waveTable[i1];
+                // Interpolation, nearest sample on the low quality tier
+                dsp_float sample = Interpolated ? (1.0 - frac) * waveTable[i0] + frac * waveTable[i1] : waveTable[i0];
 
                 // Sum weighted
                 sumL += sample * v.amp_ratio * v.gainL;
                 sumR += sample * v.amp_ratio * v.gainR;
 
                 // Advance phase
-                dsp_float inc = voiceFreq / DSP::sampleRate;
+                dsp_float inc = voiceFreq / rate;
                 v.phase += inc;
 
                 if (v.phase >= 1.0)
@@ -291,10 +490,13 @@ void WavetableOscillator::processBlock(DSPObject *dsp)
 
             outBufferL[i] = sumL;
             outBufferR[i] = sumR;
+
+            frequency *= ramp;
         }
         else
         {
             phase += phaseIncrement;
+            phaseIncrement *= ramp;
 
             if (phase >= 1.0)
             {
@@ -302,33 +504,54 @@ void WavetableOscillator::processBlock(DSPObject *dsp)
                 wrappedFlag = true;
             }
 
-            dsp_float modPhaseL = phase + mod_index * modLeft;
-            dsp_float modPhaseR = phase + mod_index * modRight;
-
-            modPhaseL -= std::floor(modPhaseL);
-            modPhaseR -= std::floor(modPhaseR);
+            dsp_float modPhaseL = phase;
 
-            dsp_float indexL = modPhaseL * osc->selectedWaveTableSize;
-            dsp_float indexR = modPhaseR * osc->selectedWaveTableSize;
+            if (Modulated)
+            {
+                modPhaseL += mod_index * modBufferL[i];
+                modPhaseL -= std::floor(modPhaseL);
+            }
 
+            dsp_float indexL = modPhaseL * waveTableSize;
             size_t i0L = static_cast<size_t>(indexL);
-            size_t i1L = (i0L + 1) % osc->selectedWaveTableSize;
+            size_t i1L = (i0L + 1) % waveTableSize;
             dsp_float fracL = indexL - i0L;
 
+            outBufferL[i] = Interpolated ? (1.0 - fracL) * waveTable[i0L] + fracL * waveTable[i1L] : waveTable[i0L];
+
+            if (Mono)
+                continue;
+
+            dsp_float modPhaseR = phase;
+
+            if (Modulated)
+            {
+                modPhaseR += mod_index * modBufferR[i];
+                modPhaseR -= std::floor(modPhaseR);
+            }
+
+            dsp_float indexR = modPhaseR * waveTableSize;
             size_t i0R = static_cast<size_t>(indexR);
-            size_t i1R = (i0R + 1) % osc->selectedWaveTableSize;
+            size_t i1R = (i0R + 1) % waveTableSize;
             dsp_float fracR = indexR - i0R;
 
-            dsp_float sampleL = (1.0 - fracL) * (*osc->selectedWaveTable)[i0L] + fracL * (*osc->selectedWaveTable)[i1L];
-            dsp_float sampleR = (1.0 - fracR) * (*osc->selectedWaveTable)[i0R] + fracR * (*osc->selectedWaveTable)[i1R];
-
-            outBufferL[i] = sampleL;
-            outBufferR[i] = sampleR;
+            outBufferR[i] = Interpolated ? (1.0 - fracR) * waveTable[i0R] + fracR * waveTable[i1R] : waveTable[i0R];
         }
     }
 
     osc->currentPhase = phase;
-    osc->wrapped = wrappedFlag;
+    osc->wrapped |= wrappedFlag;
+
+    // The modulation index reached at the end of a ramp
+    if (Modulated && indexRamp != 0.0)
+        osc->modulationIndex = clamp(mod_index, 0.0, 100.0);
+
+    // The frequency reached at the end of a ramp
+    if (ramp != 1.0)
+    {
+        osc->calculatedFrequency = Unison ? frequency : phaseIncrement * rate;
+        osc->phaseIncrement = Unison ? frequency / rate : phaseIncrement;
+    }
 }
 
 static void createDir()
@@ -354,9 +577,9 @@ static std::string absolutePath(const std::string &relativePath)
     }
 }
 
-bool WavetableOscillator::load()
+bool WavetableOscillator::load(WavetableSet &set) const
 {
-    std::string fileName = "tables/" + waveformName + "_" + std::to_string(static_cast<int>(DSP::sampleRate)) + ".wave";
+    std::string fileName = "tables/" + waveformName + "_" + std::to_string(static_cast<int>(set.sampleRate)) + ".wave";
 
     DSP::log("Try loading wavetable %s", absolutePath(fileName).c_str());
 
@@ -366,9 +589,8 @@ bool WavetableOscillator::load()
 
     DSP::log("Found wavetable %s", absolutePath(fileName).c_str());
 
-    wavetableBuffers.clear();
-    baseFrequencies.clear();
-    tableSizes.clear();
+    set.baseFrequencies.clear();
+    set.buffers.clear();
 
     std::string line;
     while (std::getline(inFile, line))
@@ -404,13 +626,12 @@ bool WavetableOscillator::load()
                 return false;
             }
 
-            baseFrequencies.push_back(freq);
-            tableSizes.push_back(size);
-            wavetableBuffers.push_back(std::make_unique<DSPBuffer>(buffer));
+            set.baseFrequencies.push_back(freq);
+            set.buffers.push_back(std::make_unique<DSPBuffer>(buffer));
         }
         catch (const std::exception &ex)
         {
-            DSP::log("Error generating wave forms from wavetable %s (%s)", absolutePath(fileName), ex.what());
+            DSP::log("Error generating wave forms from wavetable %s (%s)", absolutePath(fileName).c_str(), ex.what());
             return false;
         }
         catch (...)
@@ -422,14 +643,14 @@ bool WavetableOscillator::load()
 
     DSP::log("Wavetable %s loaded", absolutePath(fileName).c_str());
 
-    return !wavetableBuffers.empty();
+    return !set.buffers.empty();
 }
 
-void WavetableOscillator::save() const
+void WavetableOscillator::save(const WavetableSet &set) const
 {
     createDir();
 
-    std::string fileName = "tables/" + waveformName + "_" + std::to_string(static_cast<int>(DSP::sampleRate)) + ".wave";
+    std::string fileName = "tables/" + waveformName + "_" + std::to_string(static_cast<int>(set.sampleRate)) + ".wave";
     std::ofstream outFile(fileName.c_str());
 
     if (!outFile.is_open())
@@ -440,10 +661,10 @@ void WavetableOscillator::save() const
 
     try
     {
-        for (size_t i = 0; i < wavetableBuffers.size(); ++i)
+        for (size_t i = 0; i < set.buffers.size(); ++i)
         {
-            const DSPBuffer &buffer = *wavetableBuffers[i];
-            outFile << baseFrequencies[i] << "," << buffer.size();
+            const DSPBuffer &buffer = *set.buffers[i];
+            outFile << set.baseFrequencies[i] << "," << buffer.size();
 
             for (size_t j = 0; j < buffer.size(); ++j)
             {
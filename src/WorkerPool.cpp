@@ -0,0 +1,232 @@
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include "WorkerPool.h"
+#include "DSP.h"
+#include "clamp.h"
+
+// Hint to the cpu that we are busy waiting
+static inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Busy wait iterations before the joining thread yields
+static constexpr int joinSpins = 4096;
+
+// Ctor
+WorkerPool::WorkerPool()
+{
+}
+
+// Dtor: stops the workers
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+// Starts count worker threads, pinned round robin to the given cpus (empty: no pinning)
+void WorkerPool::start(int count, const std::vector<int> &cpus)
+{
+    stop();
+
+    // Leave one core to the DSP thread
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    count = clamp(count, 0, cores > 1 ? cores - 1 : 0);
+
+    if (count == 0)
+    {
+        DSP::log("WorkerPool: no worker threads, rendering on the DSP thread");
+        return;
+    }
+
+    running = true;
+
+    for (int i = 0; i < count; ++i)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this, i);
+
+        if (!cpus.empty())
+            configureThread(workers.back(), cpus[i % cpus.size()]);
+        else
+            configureThread(workers.back(), -1);
+    }
+
+    DSP::log("WorkerPool: %i worker threads started", count);
+}
+
+// Stops and joins all worker threads
+void WorkerPool::stop()
+{
+    if (workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        running = false;
+    }
+
+    parkCondition.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+
+    workers.clear();
+}
+
+// Gets the number of worker threads
+int WorkerPool::getWorkerCount() const
+{
+    return static_cast<int>(workers.size());
+}
+
+// Sets the time in microseconds an idle worker spins before it parks
+void WorkerPool::setSpinTime(dsp_float us)
+{
+    spinNanos = static_cast<long>(clampmin(us, 0.0) * 1000.0);
+}
+
+// Pins the thread to a cpu and raises it to real-time priority
+void WorkerPool::configureThread(std::thread &thread, int cpu)
+{
+    pthread_t handle = thread.native_handle();
+
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+
+        if (pthread_setaffinity_np(handle, sizeof(set), &set) != 0)
+            DSP::log("WorkerPool: could not pin worker to cpu %i", cpu);
+    }
+
+    sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 10;
+
+    if (pthread_setschedparam(handle, SCHED_FIFO, &param) != 0)
+        DSP::log("WorkerPool: real-time priority not permitted, using normal priority");
+}
+
+// Runs job for each of the count arguments and waits for completion
+void WorkerPool::run(Job job, void *const *args, int count)
+{
+    if (workers.empty())
+    {
+        for (int i = 0; i < count; ++i)
+            job(args[i]);
+
+        return;
+    }
+
+    uint32_t generation = static_cast<uint32_t>(work.load() >> 32) + 1;
+
+    currentJob.store(job, std::memory_order_relaxed);
+    currentArgs.store(args, std::memory_order_relaxed);
+    jobCount.store(count, std::memory_order_relaxed);
+    pendingJobs.store(count, std::memory_order_relaxed);
+
+    // Publish the batch
+    work.store(static_cast<uint64_t>(generation) << 32);
+
+    if (parkedWorkers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(parkMutex);
+        parkCondition.notify_all();
+    }
+
+    // The calling thread takes part
+    execute(generation);
+
+    // Join, yield if a worker has been preempted
+    for (int spins = 0; pendingJobs.load(std::memory_order_acquire) > 0; ++spins)
+    {
+        if (spins < joinSpins)
+            cpuRelax();
+        else
+            std::this_thread::yield();
+    }
+}
+
+// Claims and executes jobs of the given batch generation
+void WorkerPool::execute(uint32_t generation)
+{
+    Job job = currentJob.load(std::memory_order_relaxed);
+    void *const *args = currentArgs.load(std::memory_order_relaxed);
+    uint32_t count = static_cast<uint32_t>(jobCount.load(std::memory_order_relaxed));
+
+    uint64_t current = work.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        // Batch is done or a newer batch has been published
+        if (static_cast<uint32_t>(current >> 32) != generation)
+            return;
+
+        uint32_t index = static_cast<uint32_t>(current);
+
+        if (index >= count)
+            return;
+
+        if (!work.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel))
+            continue;
+
+        job(args[index]);
+        pendingJobs.fetch_sub(1, std::memory_order_release);
+
+        current = work.load(std::memory_order_acquire);
+    }
+}
+
+// Worker thread main loop: spin, park, execute
+void WorkerPool::workerLoop(int /*index*/)
+{
+    using clock = std::chrono::steady_clock;
+
+    uint32_t seen = static_cast<uint32_t>(work.load() >> 32);
+
+    while (running.load(std::memory_order_relaxed))
+    {
+        uint32_t generation = static_cast<uint32_t>(work.load(std::memory_order_acquire) >> 32);
+
+        if (generation != seen)
+        {
+            seen = generation;
+            execute(generation);
+            continue;
+        }
+
+        // Spin for a while to catch the next block without wakeup latency
+        auto spinEnd = clock::now() + std::chrono::nanoseconds(spinNanos.load(std::memory_order_relaxed));
+        bool published = false;
+
+        while (clock::now() < spinEnd)
+        {
+            if (static_cast<uint32_t>(work.load(std::memory_order_acquire) >> 32) != seen)
+            {
+                published = true;
+                break;
+            }
+
+            cpuRelax();
+        }
+
+        if (published)
+            continue;
+
+        // Park until the next batch
+        parkedWorkers.fetch_add(1);
+
+        {
+            std::unique_lock<std::mutex> lock(parkMutex);
+            parkCondition.wait(lock, [&]()
+                               { return !running || static_cast<uint32_t>(work.load() >> 32) != seen; });
+        }
+
+        parkedWorkers.fetch_sub(1);
+    }
+}
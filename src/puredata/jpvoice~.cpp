@@ -1,29 +1,74 @@
 // jpvoice.cpp - Pure Data external wrapping the Voice audio synthesis class
+#pragma GCC diagnostic ignored "-Wcast-function-type"
+
+#include <array>
+#include <dlfcn.h>
 #include "m_pd.h"
 #include "pdbase.h"
 #include "DSP.h"
 #include "Voice.h"
+#include "PolyVoice.h"
+#include "ParameterBlock.h"
+#include "RenderAhead.h"
+#include "SlewBank.h"
 #include "clamp.h"
 #include "dsp_types.h"
 
 static t_class *jpvoice_class;
+static t_class *jpvoice_params_class;
+
+// signal_setmultiout of Pd 0.54+, looked up at load time so the external also loads on older Pd
+using t_setmultiout = void (*)(t_signal **sig, int nchans);
+static t_setmultiout setMultiOut = nullptr;
+
+// Channels of the slew bank smoothing the [cutoff f( and [reso f( messages
+enum ControlChannel
+{
+    CutoffControl,
+    ResoControl,
+    ControlCount
+};
+
+// Parameter block shared by all [jpvoice~ -params name] under one name. It is bound to
+// the name and receives the [s name] messages once, the engines read the block by reference
+typedef struct _jpvoice_params
+{
+    t_pd pd;
+    t_symbol *name;
+    ParameterBlock *block;
+    VoiceParameters values; // Parameters as last written
+    int users;              // Number of jpvoice~ referencing the block
+} t_jpvoice_params;
 
 typedef struct _jpvoice
 {
     t_object x_obj;
-    Voice *voice;
+    PolyVoice *poly;
+    RenderAhead *ahead; // Renders poly on the DSP thread or ahead on its own thread
 
     t_inlet *in_cutoff;
     t_inlet *in_reso;
+    t_inlet *in_amp; // Amplitude of the VCA after the voice, lets a voice without envelopes sleep
     t_outlet *left_out;
     t_outlet *right_out;
+    t_outlet *quality_out; // Quality level of the governor
+    t_clock *qualityClock; // Reports a changed quality level outside the DSP tick
+    int reportedLevel;     // Quality level sent last
     dsp_float left;
     dsp_float right;
     dsp_float samplerate;
     size_t blockSize;
+    double lastTick; // Logical time of the last DSP tick
 
     DSPBuffer cutoffBuf;
     DSPBuffer resoBuf;
+    DSPBuffer ampBuf;
+
+    SlewBank *controls; // Smooths the [cutoff f( and [reso f( messages
+    bool cutoffSet;     // A [cutoff f( message replaces the cutoff inlet
+    bool resoSet;       // A [reso f( message replaces the reso inlet
+
+    t_jpvoice_params *params; // Shared parameter block or nullptr
 } t_jpvoice;
 
 bool testDSP()
@@ -37,6 +82,37 @@ bool testDSP()
     return true;
 }
 
+// Sample offset of the current message within the next block, from Pd's logical time
+static size_t eventOffset(t_jpvoice *x)
+{
+    double samples = clock_gettimesincewithunits(x->lastTick, 1, 1);
+
+    // Messages before the first block take effect at once
+    if (samples < 0.0 || samples >= static_cast<double>(x->blockSize))
+        return 0;
+
+    // The engine counts samples at its internal rate
+    return static_cast<size_t>(samples) / x->ahead->getRateDivider();
+}
+
+// Carrier type of a [carrier n( message, 1 - 8
+static CarrierOscillatiorType carrierType(int n)
+{
+    if (n < 1 || n > static_cast<int>(CarrierOscillatiorType::Modulo) + 1)
+        return CarrierOscillatiorType::Saw;
+
+    return static_cast<CarrierOscillatiorType>(n - 1);
+}
+
+// Modulator type of a [modulator n( message, 1 - 9
+static ModulatorOscillatorType modulatorType(int n)
+{
+    if (n < 1 || n > static_cast<int>(ModulatorOscillatorType::Bit) + 1)
+        return ModulatorOscillatorType::Sine;
+
+    return static_cast<ModulatorOscillatorType>(n - 1);
+}
+
 // Frequency of carrier set via list [f1 freq(
 void jpvoice_tilde_f(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 {
@@ -52,7 +128,8 @@ void jpvoice_tilde_f(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
     dsp_float f = atom_getfloat(argv);
 
-    x->voice->setFrequency(f);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setFrequency(f, sampleOffset); });
 }
 
 // Frequency offset modulator in halftones
@@ -70,7 +147,8 @@ void jpvoice_tilde_offset(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     dsp_float offset = clamp(atom_getfloat(argv), -24.0f, 24.0f);
-    x->voice->setPitchOffset(offset);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setPitchOffset(offset, sampleOffset); });
 }
 
 // Frequency fine tuning for modulator -100 - 100 [fine f(
@@ -88,7 +166,8 @@ void jpvoice_tilde_fine(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     dsp_float finetune = clamp(atom_getfloat(argv), -100.0f, 100.0f);
-    x->voice->setFineTune(finetune);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setFineTune(finetune, sampleOffset); });
 }
 
 // Frequency of modulator set via list [detune factor(
@@ -106,7 +185,8 @@ void jpvoice_tilde_detune(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     dsp_float detune = clamp(atom_getfloat(argv), 0.0f, 1.0f);
-    x->voice->setDetune(detune);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setDetune(detune, sampleOffset); });
 }
 
 // Oscillator type carrier [carrier n( 1 - 5
@@ -123,36 +203,9 @@ void jpvoice_tilde_carrier(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
         return;
     }
 
-    switch (atom_getint(argv))
-    {
-    case 1:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Saw);
-        break;
-    case 2:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Square);
-        break;
-    case 3:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Triangle);
-        break;
-    case 4:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Sine);
-        break;
-    case 5:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Cluster);
-        break;
-    case 6:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Fibonacci);
-        break;
-    case 7:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Mirror);
-        break;
-    case 8:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Modulo);
-        break;
-    default:
-        x->voice->setCarrierOscillatorType(CarrierOscillatiorType::Saw);
-        break;
-    }
+    CarrierOscillatiorType type = carrierType(atom_getint(argv));
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setCarrierOscillatorType(type, sampleOffset); });
 }
 
 // Oscillator type carrier [modulator n( 1 - 4
@@ -169,39 +222,9 @@ void jpvoice_tilde_modulator(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
         return;
     }
 
-    switch (atom_getint(argv))
-    {
-    case 1:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Saw);
-        break;
-    case 2:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Square);
-        break;
-    case 3:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Triangle);
-        break;
-    case 4:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Sine);
-        break;
-    case 5:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Cluster);
-        break;
-    case 6:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Fibonacci);
-        break;
-    case 7:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Mirror);
-        break;
-    case 8:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Modulo);
-        break;
-    case 9:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Bit);
-        break;
-    default:
-        x->voice->setModulatorOscillatorType(ModulatorOscillatorType::Sine);
-        break;
-    }
+    ModulatorOscillatorType type = modulatorType(atom_getint(argv));
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setModulatorOscillatorType(type, sampleOffset); });
 }
 
 // Sets the type of noise to white (0) or pink (1)
@@ -221,13 +244,13 @@ void jpvoice_tilde_noisetype(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     switch (atom_getint(argv))
     {
     case 0:
-        x->voice->setNoiseType(NoiseType::White);
+        x->ahead->post([=](PolyVoice *poly) { poly->setNoiseType(NoiseType::White); });
         break;
     case 1:
-        x->voice->setNoiseType(NoiseType::Pink);
+        x->ahead->post([=](PolyVoice *poly) { poly->setNoiseType(NoiseType::Pink); });
         break;
     default:
-        x->voice->setNoiseType(NoiseType::White);
+        x->ahead->post([=](PolyVoice *poly) { poly->setNoiseType(NoiseType::White); });
         break;
     }
 }
@@ -247,7 +270,8 @@ void jpvoice_tilde_oscmix(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     float mix = clamp(static_cast<float>(atom_getfloat(argv)), 0.0f, 1.0f);
-    x->voice->setOscillatorMix(mix);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setOscillatorMix(mix, sampleOffset); });
 }
 
 // Noise mix [noisemix f(
@@ -265,7 +289,8 @@ void jpvoice_tilde_noisemix(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     float mix = clamp(static_cast<float>(atom_getfloat(argv)), 0.0f, 1.0f);
-    x->voice->setNoiseMix(mix);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setNoiseMix(mix, sampleOffset); });
 }
 
 // Sets the FM modulation index [fmmod f(
@@ -283,7 +308,8 @@ void jpvoice_tilde_modidx(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     dsp_float idx = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
-    x->voice->setModIndex(idx);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setModIndex(idx, sampleOffset); });
 }
 
 // Sets the number of voices 1 - 9 [nov f(
@@ -301,7 +327,8 @@ void jpvoice_tilde_nov(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     int nov = clamp(static_cast<int>(atom_getfloat(argv)), 0.0f, 9.0f);
-    x->voice->setNumVoices(nov);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setNumVoices(nov, sampleOffset); });
 }
 
 // Oscillator sync
@@ -319,7 +346,8 @@ void jpvoice_tilde_sync(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
     }
 
     int enabled = clamp(static_cast<int>(atom_getint(argv)), 0, 1);
-    x->voice->setSyncEnabled(enabled == 1);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setSyncEnabled(enabled == 1, sampleOffset); });
 }
 
 // [filtermode <0|1|2>] → 0 = LPF12, 1 = BPF12, 2 = HPF12
@@ -342,7 +370,7 @@ void jpvoice_tilde_filtermode(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
         post("[jpvoice~] filtermode out of range 1 - 3, clamped.");
     }
 
-    x->voice->setFilterMode(static_cast<FilterMode>(clamp(mode, 1, 3)));
+    x->ahead->post([=](PolyVoice *poly) { poly->setFilterMode(static_cast<FilterMode>(clamp(mode, 1, 3))); });
 }
 
 // [carrierfb (0 - 1.2)]
@@ -361,7 +389,8 @@ void jpvoice_tilde_carrierfb(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 
     dsp_float fb = atom_getfloat(argv);
 
-    x->voice->setFeedbackCarrier(fb);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setFeedbackCarrier(fb, sampleOffset); });
 }
 
 // [carrierfb (0 - 1.2)]
@@ -380,7 +409,8 @@ void jpvoice_tilde_modulatorfb(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 
     dsp_float fb = atom_getfloat(argv);
 
-    x->voice->setFeedbackModulator(fb);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setFeedbackModulator(fb, sampleOffset); });
 }
 
 void jpvoice_tilde_cutoff(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
@@ -398,8 +428,13 @@ void jpvoice_tilde_cutoff(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 
     dsp_float cf = atom_getfloat(argv);
 
-    x->cutoffBuf.fill(cf);
-    x->voice->setFilterCutoff(&x->cutoffBuf);
+    // The first message jumps, later ones are smoothed
+    if (x->cutoffSet)
+        x->controls->setTarget(CutoffControl, cf);
+    else
+        x->controls->reset(CutoffControl, cf);
+
+    x->cutoffSet = true;
 }
 
 void jpvoice_tilde_reso(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
@@ -417,8 +452,13 @@ void jpvoice_tilde_reso(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 
     dsp_float r = atom_getfloat(argv);
 
-    x->resoBuf.fill(r);
-    x->voice->setFilterResonance(&x->resoBuf);
+    // The first message jumps, later ones are smoothed
+    if (x->resoSet)
+        x->controls->setTarget(ResoControl, r);
+    else
+        x->controls->reset(ResoControl, r);
+
+    x->resoSet = true;
 }
 
 void jpvoice_tilde_drive(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
@@ -436,7 +476,629 @@ void jpvoice_tilde_drive(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
 
     dsp_float d = atom_getfloat(argv);
 
-    x->voice->setFilterDrive(d * 20.0);
+    x->ahead->post([=](PolyVoice *poly) { poly->setFilterDrive(d * 20.0); });
+}
+
+// Plays a note on the polyphonic engine [note pitch velocity(, velocity 0 releases the note
+void jpvoice_tilde_note(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 2 || argv[0].a_type != A_FLOAT || argv[1].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected MIDI note 0 - 127 and velocity 0 - 1: [note n v(");
+        return;
+    }
+
+    int note = clamp(static_cast<int>(atom_getfloat(argv)), 0, 127);
+    dsp_float velocity = clampmin(static_cast<float>(atom_getfloat(argv + 1)), 0.0f);
+
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->noteOn(note, velocity, sampleOffset); });
+}
+
+// Pitch bend in semi tones [bend f(
+void jpvoice_tilde_bend(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument -24 - 24 for pitch bend in semi tones: [bend f(");
+        return;
+    }
+
+    dsp_float bend = clamp(atom_getfloat(argv), -24.0f, 24.0f);
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setPitchBend(bend, sampleOffset); });
+}
+
+// Portamento time in ms and curve [glide ms lin|exp(, 0 jumps to a new note
+void jpvoice_tilde_glide(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc < 1 || argc > 2 || argv[0].a_type != A_FLOAT || (argc == 2 && argv[1].a_type != A_SYMBOL))
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 - n for glide time in ms and optional curve: [glide f lin|exp(");
+        return;
+    }
+
+    SlewMode mode = SlewMode::Linear;
+
+    if (argc == 2)
+    {
+        t_symbol *curve = atom_getsymbol(argv + 1);
+
+        if (curve == gensym("exp"))
+            mode = SlewMode::Exponential;
+        else if (curve != gensym("lin"))
+        {
+            pd_error(x, "[jpvoice~]: unknown glide curve %s, expected lin or exp", curve->s_name);
+            return;
+        }
+    }
+
+    dsp_float ms = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
+    x->ahead->post([=](PolyVoice *poly) { poly->setGlide(ms, mode); });
+}
+
+// Time in ms a pitch bend change is smoothed over [bendtime ms(
+void jpvoice_tilde_bendtime(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 - n for bend time in ms: [bendtime f(");
+        return;
+    }
+
+    dsp_float ms = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
+    x->ahead->post([=](PolyVoice *poly) { poly->setBendTime(ms); });
+}
+
+// Paraphonic chord through the unison oscillators [chord st1 st2 ... (, up to 9 pitches in semi tones
+// relative to the note, fewer than two end the chord
+void jpvoice_tilde_chord(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    bool numeric = argc <= WavetableOscillator::maxVoices;
+
+    for (int i = 0; i < argc; ++i)
+        numeric = numeric && argv[i].a_type == A_FLOAT;
+
+    if (!numeric)
+    {
+        pd_error(x, "[jpvoice~]: expected up to 9 pitches in semi tones -48 - 48: [chord f f f(");
+        return;
+    }
+
+    std::array<float, WavetableOscillator::maxVoices> notes{};
+    int count = argc;
+
+    for (int i = 0; i < count; ++i)
+        notes[i] = clamp(atom_getfloat(argv + i), -48.0f, 48.0f);
+
+    x->ahead->post([=](PolyVoice *poly)
+                   {
+        dsp_float semitones[WavetableOscillator::maxVoices];
+        std::copy(notes.begin(), notes.end(), semitones);
+        poly->setChord(semitones, count); });
+}
+
+// Paraphonic note stack [paraphonic 0|1(, the held notes play as a chord through one voice
+void jpvoice_tilde_paraphonic(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected 0 (polyphonic) or 1 (paraphonic): [paraphonic n(");
+        return;
+    }
+
+    bool enabled = atom_getint(argv) != 0;
+    x->ahead->post([=](PolyVoice *poly) { poly->setParaphonic(enabled); });
+}
+
+// Output gain of the summed voices [gain f(
+void jpvoice_tilde_gain(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 - n for output gain: [gain f(");
+        return;
+    }
+
+    dsp_float g = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
+    x->ahead->post([=](PolyVoice *poly) { poly->setGain(g); });
+}
+
+// Parses an envelope message [aenv|fenv param value(, names as in adsr~
+static bool parseEnvelope(t_jpvoice *x, int argc, t_atom *argv, EnvelopeParam &param, dsp_float &value)
+{
+    if (argc != 2 || argv[0].a_type != A_SYMBOL || argv[1].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected envelope parameter and value: [aenv|fenv attack|decay|sustain|release|attackshape|releaseshape|g|oneshot f(");
+        return false;
+    }
+
+    t_symbol *name = atom_getsymbol(argv);
+    value = atom_getfloat(argv + 1);
+
+    if (name == gensym("attack"))
+        param = EnvelopeParam::Attack;
+    else if (name == gensym("decay"))
+        param = EnvelopeParam::Decay;
+    else if (name == gensym("sustain"))
+        param = EnvelopeParam::Sustain;
+    else if (name == gensym("release"))
+        param = EnvelopeParam::Release;
+    else if (name == gensym("attackshape"))
+        param = EnvelopeParam::AttackShape;
+    else if (name == gensym("releaseshape"))
+        param = EnvelopeParam::ReleaseShape;
+    else if (name == gensym("g"))
+        param = EnvelopeParam::Gain;
+    else if (name == gensym("oneshot"))
+        param = EnvelopeParam::OneShot;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown envelope parameter %s", name->s_name);
+        return false;
+    }
+
+    return true;
+}
+
+// Amplitude envelope parameter [aenv param value(
+void jpvoice_tilde_aenv(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    EnvelopeParam param;
+    dsp_float value;
+
+    if (parseEnvelope(x, argc, argv, param, value))
+        x->ahead->post([=](PolyVoice *poly) { poly->setAmpEnvelope(param, value); });
+}
+
+// Filter envelope parameter [fenv param value(, the envelope is added to the cutoff
+void jpvoice_tilde_fenv(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    EnvelopeParam param;
+    dsp_float value;
+
+    if (parseEnvelope(x, argc, argv, param, value))
+        x->ahead->post([=](PolyVoice *poly) { poly->setFilterEnvelope(param, value); });
+}
+
+// Routes a modulation source to a destination [mod source destination amount(, amount 0 removes the route
+void jpvoice_tilde_mod(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 3 || argv[0].a_type != A_SYMBOL || argv[1].a_type != A_SYMBOL || argv[2].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected source, destination and amount: [mod lfo|env|velocity|key cutoff|pitch|modidx|detune|oscmix|noise f(");
+        return;
+    }
+
+    t_symbol *src = atom_getsymbol(argv);
+    t_symbol *dst = atom_getsymbol(argv + 1);
+    ModSource source;
+    ModDestination destination;
+
+    if (src == gensym("lfo"))
+        source = ModSource::Lfo;
+    else if (src == gensym("env"))
+        source = ModSource::Envelope;
+    else if (src == gensym("velocity"))
+        source = ModSource::Velocity;
+    else if (src == gensym("key"))
+        source = ModSource::Key;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown modulation source %s", src->s_name);
+        return;
+    }
+
+    if (dst == gensym("cutoff"))
+        destination = ModDestination::Cutoff;
+    else if (dst == gensym("pitch"))
+        destination = ModDestination::Pitch;
+    else if (dst == gensym("modidx"))
+        destination = ModDestination::ModIndex;
+    else if (dst == gensym("detune"))
+        destination = ModDestination::Detune;
+    else if (dst == gensym("oscmix"))
+        destination = ModDestination::OscMix;
+    else if (dst == gensym("noise"))
+        destination = ModDestination::Noise;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown modulation destination %s", dst->s_name);
+        return;
+    }
+
+    dsp_float amount = atom_getfloat(argv + 2);
+    x->ahead->post([=](PolyVoice *poly) { poly->setModulation(source, destination, amount); });
+}
+
+// Modulation LFO parameter [modlfo param value(, names as in lfo~
+void jpvoice_tilde_modlfo(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 2 || argv[0].a_type != A_SYMBOL || argv[1].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected LFO parameter and value: [modlfo freq|type|shape|pw|smooth|offset|depth f(");
+        return;
+    }
+
+    t_symbol *name = atom_getsymbol(argv);
+    LFOParam param;
+
+    if (name == gensym("freq"))
+        param = LFOParam::Frequency;
+    else if (name == gensym("type"))
+        param = LFOParam::Type;
+    else if (name == gensym("shape"))
+        param = LFOParam::Shape;
+    else if (name == gensym("pw"))
+        param = LFOParam::PulseWidth;
+    else if (name == gensym("smooth"))
+        param = LFOParam::Smooth;
+    else if (name == gensym("offset"))
+        param = LFOParam::Offset;
+    else if (name == gensym("depth"))
+        param = LFOParam::Depth;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown LFO parameter %s", name->s_name);
+        return;
+    }
+
+    dsp_float value = atom_getfloat(argv + 1);
+    x->ahead->post([=](PolyVoice *poly) { poly->setModLfo(param, value); });
+}
+
+// Ensemble on the summed output [ensemble mix|rate|depth|delay f(, mix 0 bypasses it
+void jpvoice_tilde_ensemble(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 2 || argv[0].a_type != A_SYMBOL || argv[1].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected ensemble parameter and value: [ensemble mix|rate|depth|delay f(");
+        return;
+    }
+
+    t_symbol *name = atom_getsymbol(argv);
+    EnsembleParam param;
+
+    if (name == gensym("mix"))
+        param = EnsembleParam::Mix;
+    else if (name == gensym("rate"))
+        param = EnsembleParam::Rate;
+    else if (name == gensym("depth"))
+        param = EnsembleParam::Depth;
+    else if (name == gensym("delay"))
+        param = EnsembleParam::Delay;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown ensemble parameter %s", name->s_name);
+        return;
+    }
+
+    dsp_float value = atom_getfloat(argv + 1);
+    x->ahead->post([=](PolyVoice *poly) { poly->setEnsemble(param, value); });
+}
+
+// Preset slots [preset store|recall n(, [preset morph n ms(, [preset blend a b x(
+void jpvoice_tilde_preset(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    bool numeric = argc >= 2 && argv[0].a_type == A_SYMBOL;
+
+    for (int i = 1; i < argc; ++i)
+        numeric = numeric && argv[i].a_type == A_FLOAT;
+
+    if (!numeric)
+    {
+        pd_error(x, "[jpvoice~]: expected preset command: [preset store|recall n(, [preset morph n ms( or [preset blend a b x(");
+        return;
+    }
+
+    t_symbol *name = atom_getsymbol(argv);
+    int slot = clamp(static_cast<int>(atom_getfloat(argv + 1)), 0, PolyVoice::presetCount - 1);
+
+    if (name == gensym("store") && argc == 2)
+        x->ahead->post([=](PolyVoice *poly) { poly->storePreset(slot); });
+    else if (name == gensym("recall") && argc == 2)
+        x->ahead->post([=](PolyVoice *poly) { poly->recallPreset(slot); });
+    else if (name == gensym("morph") && argc == 3)
+    {
+        dsp_float ms = atom_getfloat(argv + 2);
+        x->ahead->post([=](PolyVoice *poly) { poly->morphPreset(slot, ms); });
+    }
+    else if (name == gensym("blend") && argc == 4)
+    {
+        int other = clamp(static_cast<int>(atom_getfloat(argv + 2)), 0, PolyVoice::presetCount - 1);
+        dsp_float amount = clamp(static_cast<dsp_float>(atom_getfloat(argv + 3)), 0.0, 1.0);
+        x->ahead->post([=](PolyVoice *poly) { poly->blendPresets(slot, other, amount); });
+    }
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown preset command %s", name->s_name);
+    }
+}
+
+// Samples between two evaluations of the modulation matrix [controlrate n(
+void jpvoice_tilde_controlrate(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 1 - 2048 for the modulation control rate in samples: [controlrate n(");
+        return;
+    }
+
+    int samples = clamp(static_cast<int>(atom_getfloat(argv)), 1, 2048);
+    x->ahead->post([=](PolyVoice *poly) { poly->setControlRate(samples); });
+}
+
+// Note gate [gate 0|1(, an open gate wakes an idle voice
+void jpvoice_tilde_gate(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 (closed) or > 0 (open) for note gate: [gate f(");
+        return;
+    }
+
+    bool open = atom_getfloat(argv) > 0;
+    size_t sampleOffset = eventOffset(x);
+    x->ahead->post([=](PolyVoice *poly) { poly->setGate(open, sampleOffset); });
+}
+
+// Time in ms parameter messages are smoothed over [smooth ms(, 0 applies them at once.
+// Smoothed are cutoff, reso, oscmix, noisemix, modidx and detune
+void jpvoice_tilde_smooth(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (!testDSP())
+    {
+        return;
+    }
+
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 - n for smoothing time in ms: [smooth f(");
+        return;
+    }
+
+    dsp_float ms = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
+    x->controls->setSlewTime(ms);
+    x->ahead->post([=](PolyVoice *poly) { poly->setSmoothTime(ms); });
+}
+
+// Number of worker threads rendering the voices [threads n(, 0 renders on the DSP thread
+void jpvoice_tilde_threads(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0 - n for number of worker threads: [threads n(");
+        return;
+    }
+
+    int count = clampmin(static_cast<int>(atom_getfloat(argv)), 0);
+    x->ahead->post([=](PolyVoice *poly) { poly->setThreads(count); });
+}
+
+// CPUs the worker threads are pinned to [affinity cpu1 cpu2 ...(, no arguments for no pinning
+void jpvoice_tilde_affinity(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    // Copied by value to the render thread
+    std::array<int, 8> cpus;
+    int count = clamp(argc, 0, static_cast<int>(cpus.size()));
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (argv[i].a_type != A_FLOAT)
+        {
+            pd_error(x, "[jpvoice~]: expected up to 8 cpu numbers for worker affinity: [affinity n n ...(");
+            return;
+        }
+
+        cpus[i] = clampmin(static_cast<int>(atom_getfloat(argv + i)), 0);
+    }
+
+    x->ahead->post([=](PolyVoice *poly)
+                   { poly->setAffinity(std::vector<int>(cpus.begin(), cpus.begin() + count)); });
+}
+
+// Time in microseconds an idle worker spins before it parks [spin us(
+void jpvoice_tilde_spin(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument 0 - n for worker spin time in microseconds: [spin f(");
+        return;
+    }
+
+    dsp_float us = clampmin(static_cast<float>(atom_getfloat(argv)), 0.0f);
+    x->ahead->post([=](PolyVoice *poly) { poly->setSpinTime(us); });
+}
+
+// Runs the voice chain on tiles of n samples [tile n(, 0 processes each stage over the whole block
+void jpvoice_tilde_tile(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0 - 2048 for tile size in samples: [tile n(");
+        return;
+    }
+
+    int samples = clamp(static_cast<int>(atom_getfloat(argv)), 0, 2048);
+    x->ahead->post([=](PolyVoice *poly) { poly->setTileSize(samples); });
+}
+
+// Renders the voices lane parallel [lanes 0|1(
+void jpvoice_tilde_lanes(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0|1 for lane rendering: [lanes n(");
+        return;
+    }
+
+    bool enabled = atom_getfloat(argv) != 0;
+    x->ahead->post([=](PolyVoice *poly) { poly->setLanesEnabled(enabled); });
+}
+
+// Freezes static oscillator setups into a single table [freeze 0|1(
+void jpvoice_tilde_freeze(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0|1 for patch freezing: [freeze n(");
+        return;
+    }
+
+    bool enabled = atom_getfloat(argv) != 0;
+    x->ahead->post([=](PolyVoice *poly) { poly->setFreezeEnabled(enabled); });
+}
+
+// Renders n blocks ahead on a separate thread [ahead n(, adds n blocks latency, 0 renders on the DSP thread
+void jpvoice_tilde_ahead(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0 - 8 for blocks rendered ahead: [ahead n(");
+        return;
+    }
+
+    int blocks = clamp(static_cast<int>(atom_getfloat(argv)), 0, RenderAhead::maxLatency);
+
+    if (blocks > 0 && x->ahead->getRateDivider() > 1)
+        pd_error(x, "[jpvoice~]: rendering ahead is only available at the host rate, takes effect with [halfrate 0(");
+
+    x->ahead->setLatency(blocks);
+}
+
+// Renders the voices at half the host rate and upsamples the output [halfrate 0|1(, needs an even block size
+void jpvoice_tilde_halfrate(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 0|1 for half rate rendering: [halfrate n(");
+        return;
+    }
+
+    bool enabled = atom_getfloat(argv) != 0;
+    x->ahead->setRateDivider(enabled ? 2 : 1);
+
+    // The engine is initialized again for the new rate
+    canvas_update_dsp();
+}
+
+// Runs the mixer feedback and the filter of the voices at 1, 2 or 4 times their rate against aliasing [oversample n(
+void jpvoice_tilde_oversample(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected int argument 1|2|4 for the oversampling factor: [oversample n(");
+        return;
+    }
+
+    int factor = static_cast<int>(atom_getfloat(argv));
+
+    if (factor != 1 && factor != 2 && factor != 4)
+    {
+        pd_error(x, "[jpvoice~]: oversampling factor %i not supported, expected 1|2|4", factor);
+        factor = clamp(factor, 1, 4);
+    }
+
+    x->ahead->post([=](PolyVoice *poly) { poly->setOversampling(factor); });
+}
+
+// Governor lowering the quality when a block takes too long [governor 0|1 (high low)(, loads as render time / deadline
+void jpvoice_tilde_governor(t_jpvoice *x, t_symbol *, int argc, t_atom *argv)
+{
+    if ((argc != 1 && argc != 3) || argv[0].a_type != A_FLOAT ||
+        (argc == 3 && (argv[1].a_type != A_FLOAT || argv[2].a_type != A_FLOAT)))
+    {
+        pd_error(x, "[jpvoice~]: expected 0|1 and optional high and low load: [governor n f f(");
+        return;
+    }
+
+    bool enabled = atom_getfloat(argv) != 0;
+
+    if (argc == 3)
+    {
+        dsp_float high = atom_getfloat(argv + 1);
+        dsp_float low = atom_getfloat(argv + 2);
+        x->ahead->post([=](PolyVoice *poly) { poly->setGovernorThresholds(high, low); });
+    }
+
+    x->ahead->post([=](PolyVoice *poly) { poly->setGovernorEnabled(enabled); });
+}
+
+// Sends the quality level of the governor
+void jpvoice_tilde_quality(t_jpvoice *x)
+{
+    x->reportedLevel = x->poly->getQualityLevel();
+    outlet_float(x->quality_out, x->reportedLevel);
 }
 
 // DSP perform function
@@ -445,20 +1107,36 @@ t_int *jpvoice_tilde_perform(t_int *w)
     t_jpvoice *x = (t_jpvoice *)(w[1]);
     t_sample *cutoff = (t_sample *)(w[2]);
     t_sample *reso = (t_sample *)(w[3]);
-    t_sample *outL = (t_sample *)(w[4]);
-    t_sample *outR = (t_sample *)(w[5]);
-    int n = (int)(w[6]);
+    t_sample *amp = (t_sample *)(w[4]);
+    t_sample *outL = (t_sample *)(w[5]);
+    t_sample *outR = (t_sample *)(w[6]);
+    int n = (int)(w[7]); // Samples of all output channels
+
+    x->lastTick = clock_getlogicaltime();
+
+    // All smoothed control messages advance in one pass
+    if (x->cutoffSet || x->resoSet)
+        x->controls->process(x->blockSize);
+
+    if (x->cutoffSet)
+        x->controls->render(CutoffControl, x->cutoffBuf, 0, x->blockSize);
+    else
+        x->cutoffBuf.set(cutoff);
+
+    if (x->resoSet)
+        x->controls->render(ResoControl, x->resoBuf, 0, x->blockSize);
+    else
+        x->resoBuf.set(reso);
 
-    x->cutoffBuf.set(cutoff);
-    x->voice->setFilterCutoff(&x->cutoffBuf);
+    x->ampBuf.set(amp);
 
-    x->resoBuf.set(reso);
-    x->voice->setFilterResonance(&x->resoBuf);
+    x->ahead->process(x->cutoffBuf, x->resoBuf, x->ampBuf);
 
-    x->voice->computeSamples();
+    if (x->poly->getQualityLevel() != x->reportedLevel)
+        clock_delay(x->qualityClock, 0);
 
-    dsp_float *bufL = x->voice->mixBufferL.data();
-    dsp_float *bufR = x->voice->mixBufferR.data();
+    const dsp_float *bufL = x->ahead->getOutputL().data();
+    const dsp_float *bufR = x->ahead->getOutputR().data();
 
     for (int i = 0; i < n; ++i)
     {
@@ -466,7 +1144,7 @@ t_int *jpvoice_tilde_perform(t_int *w)
         outR[i] = static_cast<t_sample>(bufR[i]);
     }
 
-    return (w + 7);
+    return (w + 8);
 }
 
 // DSP add function
@@ -479,33 +1157,176 @@ void jpvoice_tilde_dsp(t_jpvoice *x, t_signal **sp)
 
     x->cutoffBuf.resize(x->blockSize);
     x->resoBuf.resize(x->blockSize);
+    x->ampBuf.resize(x->blockSize);
 
-    x->voice->initialize();
+    // The control values set so far survive the new sample rate
+    dsp_float cutoff = x->controls->getTarget(CutoffControl);
+    dsp_float reso = x->controls->getTarget(ResoControl);
 
-    dsp_add(jpvoice_tilde_perform, 6,
+    x->controls->initialize();
+    x->controls->reset(CutoffControl, cutoff);
+    x->controls->reset(ResoControl, reso);
+
+    // The engine is initialized for its internal rate, the render thread restarts with the new block size
+    x->ahead->initialize();
+
+    // A multichannel class allocates its outputs, one channel per voice with separate outputs
+    int channels = x->poly->getOutputChannels();
+
+    if (setMultiOut)
+    {
+        setMultiOut(&sp[3], channels);
+        setMultiOut(&sp[4], channels);
+    }
+
+    dsp_add(jpvoice_tilde_perform, 7,
             x,
-            sp[0]->s_vec, // in_cutoff
-            sp[1]->s_vec, // in_reso
-            sp[2]->s_vec, // outL
-            sp[3]->s_vec, // outR
-            sp[0]->s_n);
+            sp[0]->s_vec, // in_cutoff, first channel
+            sp[1]->s_vec, // in_reso, first channel
+            sp[2]->s_vec, // in_amp, first channel
+            sp[3]->s_vec, // outL
+            sp[4]->s_vec, // outR
+            sp[0]->s_n * channels);
 }
 
-// Constructor
-void *jpvoice_tilde_new()
+// Shared parameter [s name( messages with the ranges of the jpvoice~ messages: carrier, modulator,
+// noisetype, oscmix, noisemix, modidx, nov, sync, detune, offset, fine, carrierfb, modulatorfb, drive
+void jpvoice_params_anything(t_jpvoice_params *x, t_symbol *s, int argc, t_atom *argv)
+{
+    if (argc != 1 || argv[0].a_type != A_FLOAT)
+    {
+        pd_error(x, "[jpvoice~]: expected float argument for shared parameter: [%s f(", s->s_name);
+        return;
+    }
+
+    VoiceParameters &values = x->values;
+    t_float f = atom_getfloat(argv);
+
+    if (s == gensym("carrier"))
+        values.carrierType = static_cast<int>(carrierType(static_cast<int>(f)));
+    else if (s == gensym("modulator"))
+        values.modulatorType = static_cast<int>(modulatorType(static_cast<int>(f)));
+    else if (s == gensym("noisetype"))
+        values.noiseType = static_cast<int>(static_cast<int>(f) == 1 ? NoiseType::Pink : NoiseType::White);
+    else if (s == gensym("oscmix"))
+        values.oscMix = clamp(f, 0.0f, 1.0f);
+    else if (s == gensym("noisemix"))
+        values.noiseMix = clamp(f, 0.0f, 1.0f);
+    else if (s == gensym("modidx"))
+        values.modIndex = clampmin(f, 0.0f);
+    else if (s == gensym("nov"))
+        values.numVoices = clamp(static_cast<int>(f), 0, 9);
+    else if (s == gensym("sync"))
+        values.sync = clamp(static_cast<int>(f), 0, 1);
+    else if (s == gensym("detune"))
+        values.detune = clamp(f, 0.0f, 1.0f);
+    else if (s == gensym("offset"))
+        values.pitchOffset = static_cast<int>(clamp(f, -24.0f, 24.0f));
+    else if (s == gensym("fine"))
+        values.fineTune = clamp(f, -100.0f, 100.0f);
+    else if (s == gensym("carrierfb"))
+        values.feedbackCarrier = f;
+    else if (s == gensym("modulatorfb"))
+        values.feedbackModulator = f;
+    else if (s == gensym("drive"))
+        values.drive = f * 20.0;
+    else
+    {
+        pd_error(x, "[jpvoice~]: unknown shared parameter %s", s->s_name);
+        return;
+    }
+
+    // One write for all engines sharing the block
+    x->block->write(values);
+}
+
+// Finds the parameter block bound to name or creates it
+static t_jpvoice_params *jpvoice_params_acquire(t_symbol *name)
+{
+    t_jpvoice_params *x = (t_jpvoice_params *)pd_findbyclass(name, jpvoice_params_class);
+
+    if (!x)
+    {
+        x = (t_jpvoice_params *)pd_new(jpvoice_params_class);
+        x->name = name;
+        x->block = new ParameterBlock();
+        x->values = VoiceParameters();
+        x->users = 0;
+        pd_bind(&x->pd, name);
+    }
+
+    ++x->users;
+    return x;
+}
+
+// Releases a parameter block, the last user deletes it
+static void jpvoice_params_release(t_jpvoice_params *x)
+{
+    if (--x->users > 0)
+        return;
+
+    pd_unbind(&x->pd, x->name);
+    delete x->block;
+    pd_free(&x->pd);
+}
+
+// Constructor: [jpvoice~] is a single voice, [jpvoice~ n] a polyphonic engine with n voices,
+// [jpvoice~ n -mc] outputs every voice on its own channel of two n channel signals,
+// [jpvoice~ -params name] reads the sound parameters sent to [s name] from a block shared by name
+void *jpvoice_tilde_new(t_symbol *, int argc, t_atom *argv)
 {
     t_jpvoice *x = (t_jpvoice *)pd_new(jpvoice_class);
 
     // register logger for DSP objects
     DSP::registerLogger(&log);
 
-    x->voice = new Voice();
+    int voices = 0;
+    bool multichannel = false;
+    t_symbol *params = nullptr;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        if (argv[i].a_type == A_FLOAT)
+            voices = static_cast<int>(atom_getfloat(argv + i));
+        else if (atom_getsymbol(argv + i) == gensym("-mc"))
+            multichannel = true;
+        else if (atom_getsymbol(argv + i) == gensym("-params") && i + 1 < argc && argv[i + 1].a_type == A_SYMBOL)
+            params = atom_getsymbol(argv + ++i);
+    }
+
+    if (multichannel && !setMultiOut)
+    {
+        pd_error(x, "[jpvoice~]: multichannel output needs Pd 0.54 or later, summing the voices");
+        multichannel = false;
+    }
+
+    x->poly = new PolyVoice(voices > 0 ? voices : 1);
+    x->poly->setEnvelopesEnabled(voices > 0);
+    x->poly->setSeparateOutputs(multichannel);
+    x->ahead = new RenderAhead(x->poly);
+
+    x->params = params ? jpvoice_params_acquire(params) : nullptr;
+
+    if (x->params)
+        x->poly->setParameterBlock(x->params->block);
+
+    x->controls = new SlewBank(ControlCount, 0.0);
+    x->cutoffSet = false;
+    x->resoSet = false;
 
     x->in_cutoff = inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
     x->in_reso = inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
+    x->in_amp = inlet_new(&x->x_obj, &x->x_obj.ob_pd, &s_signal, &s_signal);
+
+    // Full amplitude until a VCA envelope is connected
+    pd_float((t_pd *)x->in_amp, 1.0);
 
     x->left_out = outlet_new(&x->x_obj, &s_signal);
     x->right_out = outlet_new(&x->x_obj, &s_signal);
+    x->quality_out = outlet_new(&x->x_obj, &s_float);
+
+    x->qualityClock = clock_new(x, (t_method)jpvoice_tilde_quality);
+    x->reportedLevel = 0;
 
     return (void *)x;
 }
@@ -515,20 +1336,37 @@ void jpvoice_tilde_free(t_jpvoice *x)
 {
     inlet_free(x->in_cutoff);
     inlet_free(x->in_reso);
+    inlet_free(x->in_amp);
     outlet_free(x->left_out);
     outlet_free(x->right_out);
+    outlet_free(x->quality_out);
+    clock_free(x->qualityClock);
+
+    delete x->ahead;
+    delete x->poly;
+    delete x->controls;
 
-    delete x->voice;
+    if (x->params)
+        jpvoice_params_release(x->params);
 }
 
 // Setup function
 extern "C" void jpvoice_tilde_setup(void)
 {
+    int major, minor, bugfix;
+    int flags = CLASS_DEFAULT;
+
+    sys_getversion(&major, &minor, &bugfix);
+
+    if ((major > 0 || minor >= 54) && (setMultiOut = (t_setmultiout)dlsym(RTLD_DEFAULT, "signal_setmultiout")))
+        flags |= CLASS_MULTICHANNEL;
+
     jpvoice_class = class_new(gensym("jpvoice~"),
                               (t_newmethod)jpvoice_tilde_new,
                               (t_method)jpvoice_tilde_free,
                               sizeof(t_jpvoice),
-                              CLASS_DEFAULT,
+                              flags,
+                              A_GIMME,
                               A_NULL);
 
     class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_dsp, gensym("dsp"), A_CANT, 0);
@@ -549,4 +1387,34 @@ extern "C" void jpvoice_tilde_setup(void)
     class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_cutoff, gensym("cutoff"), A_GIMME, 0);
     class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_reso, gensym("reso"), A_GIMME, 0);
     class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_drive, gensym("drive"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_gate, gensym("gate"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_note, gensym("note"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_bend, gensym("bend"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_glide, gensym("glide"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_bendtime, gensym("bendtime"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_chord, gensym("chord"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_paraphonic, gensym("paraphonic"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_gain, gensym("gain"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_aenv, gensym("aenv"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_fenv, gensym("fenv"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_mod, gensym("mod"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_modlfo, gensym("modlfo"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_ensemble, gensym("ensemble"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_preset, gensym("preset"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_controlrate, gensym("controlrate"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_threads, gensym("threads"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_affinity, gensym("affinity"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_spin, gensym("spin"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_lanes, gensym("lanes"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_freeze, gensym("freeze"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_tile, gensym("tile"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_ahead, gensym("ahead"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_halfrate, gensym("halfrate"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_oversample, gensym("oversample"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_governor, gensym("governor"), A_GIMME, 0);
+    class_addmethod(jpvoice_class, (t_method)jpvoice_tilde_smooth, gensym("smooth"), A_GIMME, 0);
+
+    // Shared parameter blocks are created by the first [jpvoice~ -params name]
+    jpvoice_params_class = class_new(gensym("jpvoice-params"), 0, 0, sizeof(t_jpvoice_params), CLASS_PD, A_NULL);
+    class_addanything(jpvoice_params_class, jpvoice_params_anything);
 }